@@ -0,0 +1,143 @@
+#
+# Footprint report and budget check for the watchface builds.
+#
+# Load it from a project wscript (in `options`, `configure` and
+# `build`) with:
+#
+#     ctx.load('footprint', tooldir='../buildtools')
+#
+# and call `ctx.pbl_footprint(binaries)` after the platform loop. Once
+# the build succeeds it prints a per-module .text/.data/.bss breakdown
+# (from the objects linked into each app) plus the ELF totals and the
+# resource pack size for every platform, then fails the build when a
+# platform exceeds its budget.
+#
+# Budgets are plain byte counts per platform, shared by all the faces
+# in `BUDGETS` below so they cannot drift apart. A face may pass its own
+# table as `budgets` instead. In both, `app` limits text + data + bss
+# of the app ELF and `resources` limits the size of
+# `app_resources.pbpack`. Platforms without an entry are reported but
+# never fail.
+#
+# `./waf configure --size-profile` (or `pebble build -- --size-profile`
+# after configuring that way) turns on LTO and section GC for every
+# platform, so the numbers can be compared with the default profile.
+#
+import os
+import subprocess
+
+from waflib import Errors, Logs
+from waflib.Configure import conf
+
+BUDGETS = {
+    'aplite': {'app': 16 * 1024, 'resources': 96 * 1024},
+    'basalt': {'app': 48 * 1024, 'resources': 256 * 1024},
+    'chalk': {'app': 48 * 1024, 'resources': 256 * 1024},
+    'diorite': {'app': 48 * 1024, 'resources': 256 * 1024},
+    'emery': {'app': 96 * 1024, 'resources': 256 * 1024},
+}
+
+SIZE_PROFILE_CFLAGS = ['-flto', '-ffunction-sections', '-fdata-sections']
+SIZE_PROFILE_LINKFLAGS = ['-flto', '-Wl,--gc-sections']
+
+
+def options(opt):
+    opt.add_option('--size-profile', action='store_true', default=False,
+                   help='build with LTO and section garbage collection')
+
+
+def configure(ctx):
+    if not ctx.options.size_profile:
+        return
+
+    for platform in ctx.env.TARGET_PLATFORMS:
+        env = ctx.all_envs[platform]
+        env.append_value('CFLAGS', SIZE_PROFILE_CFLAGS)
+        env.append_value('LINKFLAGS', SIZE_PROFILE_LINKFLAGS)
+        env.SIZE_PROFILE = True
+
+
+def _size_tool(env):
+    cc = env.CC[0] if isinstance(env.CC, list) else env.CC
+    if cc.endswith('gcc'):
+        return cc[:-3] + 'size'
+    return 'arm-none-eabi-size'
+
+
+def _read_sizes(env, paths):
+    """Run `size` in Berkeley format, returning {path: (text, data, bss)}."""
+    output = subprocess.check_output([_size_tool(env)] + paths).decode('utf-8')
+    sizes = {}
+    for line in output.splitlines()[1:]:
+        fields = line.split()
+        if len(fields) < 6:
+            continue
+        text, data, bss = (int(value) for value in fields[:3])
+        sizes[' '.join(fields[5:])] = (text, data, bss)
+    return sizes
+
+
+def _module_name(node):
+    # waf names objects like `simplebig.c.3.o`
+    return node.name.split('.c.')[0]
+
+
+def _linked_objects(ctx, app_elf):
+    # The SDK compiles every platform into the shared build/src, so the
+    # objects are taken from the link task of the app, not globbed.
+    try:
+        program = ctx.get_tgen_by_name(app_elf)
+    except Errors.WafError:
+        return []
+    link_task = getattr(program, 'link_task', None)
+    if link_task is None:
+        return []
+    return sorted((node for node in link_task.inputs if node.name.endswith('.o')), key=_module_name)
+
+
+def _report_platform(ctx, platform, app_elf, budget):
+    env = ctx.all_envs[platform]
+    build_dir = ctx.bldnode.find_node(env.BUILD_DIR)
+    elf = ctx.bldnode.find_node(app_elf)
+    if build_dir is None or elf is None:
+        Logs.warn('footprint: nothing built for {}'.format(platform))
+        return []
+
+    objects = _linked_objects(ctx, app_elf)
+    sizes = _read_sizes(env, [node.abspath() for node in objects] + [elf.abspath()])
+
+    profile = 'size' if env.SIZE_PROFILE else 'default'
+    Logs.pprint('CYAN', 'Footprint for {} ({} profile):'.format(platform, profile))
+    Logs.pprint('NORMAL', '  {:<16} {:>7} {:>7} {:>7}'.format('module', '.text', '.data', '.bss'))
+    for node in objects:
+        text, data, bss = sizes[node.abspath()]
+        Logs.pprint('NORMAL', '  {:<16} {:>7} {:>7} {:>7}'.format(_module_name(node), text, data, bss))
+
+    text, data, bss = sizes[elf.abspath()]
+    app_size = text + data + bss
+    Logs.pprint('NORMAL', '  {:<16} {:>7} {:>7} {:>7} = {}'.format('app elf', text, data, bss, app_size))
+
+    pbpack = build_dir.find_node('app_resources.pbpack')
+    resources_size = os.path.getsize(pbpack.abspath()) if pbpack else 0
+    Logs.pprint('NORMAL', '  {:<16} {:>7}'.format('resources', resources_size))
+
+    errors = []
+    if budget.get('app') and app_size > budget['app']:
+        errors.append('{}: app is {} bytes, budget is {}'.format(platform, app_size, budget['app']))
+    if budget.get('resources') and resources_size > budget['resources']:
+        errors.append('{}: resources are {} bytes, budget is {}'.format(
+            platform, resources_size, budget['resources']))
+    return errors
+
+
+@conf
+def pbl_footprint(ctx, binaries, budgets=BUDGETS):
+    def report(ctx):
+        errors = []
+        for binary in binaries:
+            platform = binary['platform']
+            errors += _report_platform(ctx, platform, binary['app_elf'], budgets.get(platform, {}))
+        if errors:
+            ctx.fatal('Footprint budget exceeded:\n  ' + '\n  '.join(errors))
+
+    ctx.add_post_fun(report)
@@ -0,0 +1,1810 @@
+// Software stand-in for the Pebble SDK, for the headless render harness
+// (see buildtools/render.py). The faces are compiled unchanged against
+// pebble.h and linked with this file; their main() runs as on the watch,
+// and app_event_loop() plays a fixed scene on a virtual clock instead of
+// waiting for events:
+//
+//   launch  the first frame after init, at 10:14
+//   tick    the minute tick to 10:15 and a battery drop from 40 to 30 %,
+//           with any animation played out
+//   peek    a 51 px timeline peek obstructing the bottom (rect only)
+//
+// Every step renders the layer tree when something was marked dirty, as
+// the watch does, writes the last frame to $HEADLESS_OUT/<step>.ppm and
+// prints one line with the redraws of the step, the graphics calls they
+// made and the pixels those calls wrote:
+//
+//   frame tick: 2 redraws, 31 draws, 9120 px
+//
+// A frame buffer capture that changed pixels counts as one draw, with
+// the pixels it changed. The rasterizer covers what the faces use and
+// draws text with one 6x11 bitmap font scaled to the font size, so text
+// lands where it would on the watch without the exact glyphs.
+#include <math.h>
+#include <stdarg.h>
+
+#include "pebble.h"
+#include "glyphs.h"
+#include "vars.h"
+
+#define SCREEN_WIDTH PBL_DISPLAY_WIDTH
+#define SCREEN_HEIGHT PBL_DISPLAY_HEIGHT
+#ifdef PBL_BW
+#define SCREEN_ROW_SIZE 20
+#else
+#define SCREEN_ROW_SIZE SCREEN_WIDTH
+#endif
+
+// 2024-03-01 10:14 UTC, a minute before a quarter hour
+#define SCENE_START 1709288040
+#define SCENE_BATTERY_PERCENT 40
+// the minute tick comes with a battery event
+#define SCENE_TICK_BATTERY_PERCENT 30
+#define SCENE_STEPS 5234
+#define SCENE_PEEK_HEIGHT 51
+// a frame every 30 ms while animations run
+#define ANIMATION_FRAME_MS 30
+
+// Logging
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+    const char *name = strrchr(src_filename, '/');
+    fprintf(stderr, "[%d] %s:%d> ", log_level, name ? name + 1 : src_filename, src_line_number);
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+// Virtual clock: time() and time_ms() only move when the scene moves them.
+
+static uint64_t clock_ms = (uint64_t)SCENE_START * 1000;
+
+time_t time(time_t *tloc) {
+    time_t now = clock_ms / 1000;
+    if (tloc) {
+        *tloc = now;
+    }
+    return now;
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+    uint16_t ms = clock_ms % 1000;
+    if (tloc) {
+        *tloc = clock_ms / 1000;
+    }
+    if (out_ms) {
+        *out_ms = ms;
+    }
+    return ms;
+}
+
+time_t time_start_of_today(void) {
+    time_t now = time(NULL);
+    return now - now % (24 * 60 * 60);
+}
+
+bool clock_is_24h_style(void) {
+    return true;
+}
+
+// Geometry
+
+bool gpoint_equal(const GPoint *point_a, const GPoint *point_b) {
+    return point_a->x == point_b->x && point_a->y == point_b->y;
+}
+
+bool gsize_equal(const GSize *size_a, const GSize *size_b) {
+    return size_a->w == size_b->w && size_a->h == size_b->h;
+}
+
+bool grect_equal(const GRect *rect_a, const GRect *rect_b) {
+    return gpoint_equal(&rect_a->origin, &rect_b->origin) && gsize_equal(&rect_a->size, &rect_b->size);
+}
+
+GRect grect_inset(GRect rect, GEdgeInsets insets) {
+    GRect result = GRect(rect.origin.x + insets.left, rect.origin.y + insets.top,
+                         rect.size.w - insets.left - insets.right, rect.size.h - insets.top - insets.bottom);
+    if (result.size.w < 0 || result.size.h < 0) {
+        return GRectZero;
+    }
+    return result;
+}
+
+static GRect grect_intersection(GRect a, GRect b) {
+    int x0 = a.origin.x > b.origin.x ? a.origin.x : b.origin.x;
+    int y0 = a.origin.y > b.origin.y ? a.origin.y : b.origin.y;
+    int x1 = a.origin.x + a.size.w < b.origin.x + b.size.w ? a.origin.x + a.size.w : b.origin.x + b.size.w;
+    int y1 = a.origin.y + a.size.h < b.origin.y + b.size.h ? a.origin.y + a.size.h : b.origin.y + b.size.h;
+    if (x1 <= x0 || y1 <= y0) {
+        return GRectZero;
+    }
+    return GRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+bool gcolor_equal(GColor8 color_a, GColor8 color_b) {
+    return color_a.argb == color_b.argb;
+}
+
+// Trigonometry, from libm rather than the SDK tables
+
+int32_t sin_lookup(int32_t angle) {
+    return (int32_t)lround(sin(angle * 2 * M_PI / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle) {
+    return (int32_t)lround(cos(angle * 2 * M_PI / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t atan2_lookup(int16_t y, int16_t x) {
+    double angle = atan2(y, x);
+    if (angle < 0) {
+        angle += 2 * M_PI;
+    }
+    return (int32_t)(angle * TRIG_MAX_ANGLE / (2 * M_PI)) % TRIG_MAX_ANGLE;
+}
+
+// Bitmaps
+
+struct GBitmap {
+    GBitmapFormat format;
+    GSize size;
+    uint16_t row_size;
+    uint8_t *data;
+    GColor *palette;
+    bool free_palette;
+};
+
+static uint16_t row_size_for(GBitmapFormat format, int width) {
+    switch (format) {
+    case GBitmapFormat1Bit:
+        return (width + 31) / 32 * 4;
+    case GBitmapFormat1BitPalette:
+        return (width + 7) / 8;
+    case GBitmapFormat2BitPalette:
+        return (width + 3) / 4;
+    case GBitmapFormat4BitPalette:
+        return (width + 1) / 2;
+    default:
+        return width;
+    }
+}
+
+static int palette_size_for(GBitmapFormat format) {
+    switch (format) {
+    case GBitmapFormat1BitPalette:
+        return 2;
+    case GBitmapFormat2BitPalette:
+        return 4;
+    case GBitmapFormat4BitPalette:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor *palette,
+                                           bool free_on_destroy) {
+    GBitmap *bitmap = calloc(1, sizeof(GBitmap));
+    bitmap->format = format;
+    bitmap->size = size;
+    bitmap->row_size = row_size_for(format, size.w);
+    bitmap->data = calloc(bitmap->row_size * size.h + 4, 1);
+    bitmap->palette = palette;
+    bitmap->free_palette = free_on_destroy;
+    return bitmap;
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format) {
+    int palette_size = palette_size_for(format);
+    GColor *palette = palette_size ? calloc(palette_size, sizeof(GColor)) : NULL;
+    return gbitmap_create_blank_with_palette(size, format, palette, true);
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+    if (!bitmap) {
+        return;
+    }
+    if (bitmap->free_palette) {
+        free(bitmap->palette);
+    }
+    free(bitmap->data);
+    free(bitmap);
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+    return GRect(0, 0, bitmap->size.w, bitmap->size.h);
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+    return bitmap->data;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+    return bitmap->row_size;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+    return bitmap->format;
+}
+
+GColor *gbitmap_get_palette(const GBitmap *bitmap) {
+    return bitmap->palette;
+}
+
+void gbitmap_set_palette(GBitmap *bitmap, GColor *palette, bool free_on_destroy) {
+    if (bitmap->free_palette) {
+        free(bitmap->palette);
+    }
+    bitmap->palette = palette;
+    bitmap->free_palette = free_on_destroy;
+}
+
+// Rows of the round display only hold the pixels inside the circle.
+static void row_span(int y, int16_t *min_x, int16_t *max_x) {
+    #ifdef PBL_ROUND
+    double radius = SCREEN_WIDTH / 2.0;
+    double dy = y + 0.5 - radius;
+    double half = sqrt(radius * radius - dy * dy);
+    *min_x = (int16_t)lround(radius - half);
+    *max_x = SCREEN_WIDTH - 1 - *min_x;
+    #else
+    *min_x = 0;
+    *max_x = SCREEN_WIDTH - 1;
+    #endif
+}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y) {
+    GBitmapDataRowInfo row = {
+        .data = bitmap->data + y * bitmap->row_size,
+        .min_x = 0,
+        .max_x = bitmap->size.w - 1,
+    };
+    if (bitmap->format == GBitmapFormat8BitCircular) {
+        row_span(y, &row.min_x, &row.max_x);
+    }
+    return row;
+}
+
+static GColor bitmap_pixel(const GBitmap *bitmap, int x, int y) {
+    const uint8_t *row = bitmap->data + y * bitmap->row_size;
+    switch (bitmap->format) {
+    case GBitmapFormat1Bit:
+        return (row[x / 8] >> (x % 8)) & 1 ? GColorWhite : GColorBlack;
+    case GBitmapFormat1BitPalette:
+        return bitmap->palette[(row[x / 8] >> (7 - x % 8)) & 1];
+    case GBitmapFormat2BitPalette:
+        return bitmap->palette[(row[x / 4] >> (6 - 2 * (x % 4))) & 3];
+    case GBitmapFormat4BitPalette:
+        return bitmap->palette[(row[x / 2] >> (4 - 4 * (x % 2))) & 15];
+    default:
+        return (GColor8){.argb = row[x]};
+    }
+}
+
+// Resources, as written by render.py: $HEADLESS_RESOURCES/<id>.bin
+
+struct ResourceFile {
+    uint32_t id;
+    size_t size;
+    uint8_t *data;
+};
+
+#define MAX_RESOURCES 64
+
+static struct ResourceFile resources[MAX_RESOURCES];
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+    if (resource_id >= MAX_RESOURCES) {
+        return NULL;
+    }
+    struct ResourceFile *resource = &resources[resource_id];
+    if (resource->data) {
+        return resource;
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%u.bin", getenv("HEADLESS_RESOURCES"), (unsigned)resource_id);
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "no resource %s", path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    resource->size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    resource->data = malloc(resource->size ? resource->size : 1);
+    if (fread(resource->data, 1, resource->size, file) != resource->size) {
+        resource->size = 0;
+    }
+    fclose(file);
+    resource->id = resource_id;
+    return resource;
+}
+
+size_t resource_size(ResHandle handle) {
+    return handle ? handle->size : 0;
+}
+
+size_t resource_load_byte_range(ResHandle handle, uint32_t start_offset, uint8_t *buffer, size_t num_bytes) {
+    if (!handle || start_offset >= handle->size) {
+        return 0;
+    }
+    if (num_bytes > handle->size - start_offset) {
+        num_bytes = handle->size - start_offset;
+    }
+    memcpy(buffer, handle->data + start_offset, num_bytes);
+    return num_bytes;
+}
+
+size_t resource_load(ResHandle handle, uint8_t *buffer, size_t max_length) {
+    return resource_load_byte_range(handle, 0, buffer, max_length);
+}
+
+// Bitmap resources: format, palette size, width, height and row size
+// (uint8, uint8, 3 x uint16 little endian), the palette, then the rows.
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+    ResHandle handle = resource_get_handle(resource_id);
+    if (!handle || handle->size < 8) {
+        return NULL;
+    }
+    const uint8_t *header = handle->data;
+    int palette_size = header[1];
+    GSize size = GSize(header[2] | header[3] << 8, header[4] | header[5] << 8);
+
+    GBitmap *bitmap = gbitmap_create_blank(size, header[0]);
+    if (palette_size) {
+        memcpy(bitmap->palette, header + 8, palette_size);
+    }
+    memcpy(bitmap->data, header + 8 + palette_size, bitmap->row_size * size.h);
+    return bitmap;
+}
+
+// Fonts
+
+struct GFontInfo {
+    char key[48];
+    int size;
+    bool bold;
+};
+
+#define MAX_FONTS 16
+
+static struct GFontInfo fonts[MAX_FONTS];
+static int font_count = 0;
+
+// The size is the number in the key, "RESOURCE_ID_GOTHIC_14_BOLD" is 14.
+GFont fonts_get_system_font(const char *font_key) {
+    for (int i = 0; i < font_count; i++) {
+        if (strcmp(fonts[i].key, font_key) == 0) {
+            return &fonts[i];
+        }
+    }
+    if (font_count == MAX_FONTS) {
+        return &fonts[0];
+    }
+
+    GFont font = &fonts[font_count++];
+    snprintf(font->key, sizeof(font->key), "%s", font_key);
+    font->size = GLYPH_HEIGHT;
+    for (const char *c = font_key; *c; c++) {
+        if (*c >= '0' && *c <= '9' && c[-1] == '_') {
+            font->size = atoi(c);
+            break;
+        }
+    }
+    font->bold = strstr(font_key, "BOLD") != NULL;
+    return font;
+}
+
+static int glyph_advance(GFont font) {
+    int advance = font->size * GLYPH_WIDTH / GLYPH_HEIGHT;
+    return advance > 0 ? advance : 1;
+}
+
+// Drawing context and frame buffer
+
+struct GContext {
+    GBitmap *frame_buffer;
+    // screen coordinates of the drawing box origin, and the clip
+    GPoint offset;
+    GRect clip;
+    GColor fill_color;
+    GColor stroke_color;
+    GColor text_color;
+    GCompOp compositing_mode;
+    bool frame_buffer_captured;
+};
+
+static GContext context;
+static uint8_t *captured_pixels;
+
+// per step counters
+static int step_redraws;
+static int step_draws;
+static long step_pixels;
+
+static void frame_buffer_init(void) {
+    context.frame_buffer = gbitmap_create_blank(GSize(SCREEN_WIDTH, SCREEN_HEIGHT),
+                                                PBL_IF_BW_ELSE(GBitmapFormat1Bit, PBL_IF_ROUND_ELSE(GBitmapFormat8BitCircular, GBitmapFormat8Bit)));
+    // same size, but rows of 20 bytes on 144 px as on the watch
+    context.frame_buffer->row_size = SCREEN_ROW_SIZE;
+    #ifdef PBL_COLOR
+    memset(context.frame_buffer->data, GColorBlackARGB8, SCREEN_ROW_SIZE * SCREEN_HEIGHT);
+    #endif
+    captured_pixels = malloc(SCREEN_ROW_SIZE * SCREEN_HEIGHT);
+}
+
+static bool on_screen(int x, int y) {
+    if (y < 0 || y >= SCREEN_HEIGHT) {
+        return false;
+    }
+    int16_t min_x, max_x;
+    row_span(y, &min_x, &max_x);
+    return x >= min_x && x <= max_x;
+}
+
+#ifdef PBL_BW
+static bool frame_buffer_bit(int x, int y) {
+    return (context.frame_buffer->data[y * SCREEN_ROW_SIZE + x / 8] >> (x % 8)) & 1;
+}
+
+static void frame_buffer_set_bit(int x, int y, bool white) {
+    uint8_t *byte = &context.frame_buffer->data[y * SCREEN_ROW_SIZE + x / 8];
+    if (white) {
+        *byte |= 1 << (x % 8);
+    } else {
+        *byte &= ~(1 << (x % 8));
+    }
+}
+
+// Black and white panels show the light colors as white.
+static bool is_white(GColor color) {
+    return color.r + color.g + color.b >= 5;
+}
+#endif
+
+// Writes one pixel in drawing box coordinates, within the clip.
+static void put_pixel(GContext *ctx, int x, int y, GColor color) {
+    x += ctx->offset.x;
+    y += ctx->offset.y;
+    if (color.a == 0 || x < ctx->clip.origin.x || y < ctx->clip.origin.y
+            || x >= ctx->clip.origin.x + ctx->clip.size.w || y >= ctx->clip.origin.y + ctx->clip.size.h
+            || !on_screen(x, y)) {
+        return;
+    }
+    #ifdef PBL_BW
+    frame_buffer_set_bit(x, y, is_white(color));
+    #else
+    ctx->frame_buffer->data[y * SCREEN_ROW_SIZE + x] = color.argb | 0xC0;
+    #endif
+    step_pixels++;
+}
+
+// Composites one bitmap pixel, see GCompOp.
+static void put_bitmap_pixel(GContext *ctx, int x, int y, GColor source) {
+    #ifdef PBL_BW
+    int screen_x = x + ctx->offset.x;
+    int screen_y = y + ctx->offset.y;
+    if (!on_screen(screen_x, screen_y)) {
+        return;
+    }
+    bool white = is_white(source);
+    bool destination = frame_buffer_bit(screen_x, screen_y);
+    switch (ctx->compositing_mode) {
+    case GCompOpAssign:
+        break;
+    case GCompOpAssignInverted:
+        white = !white;
+        break;
+    case GCompOpOr:
+        white = white || destination;
+        break;
+    case GCompOpAnd:
+        white = white && destination;
+        break;
+    case GCompOpClear:
+        // white source pixels paint black
+        if (!white) {
+            return;
+        }
+        white = false;
+        break;
+    case GCompOpSet:
+        // black source pixels paint white
+        if (white || source.a == 0) {
+            return;
+        }
+        white = true;
+        break;
+    }
+    put_pixel(ctx, x, y, white ? GColorWhite : GColorBlack);
+    #else
+    if (ctx->compositing_mode == GCompOpSet) {
+        // transparent pixels stay out, the rest is drawn opaque
+        if (source.a < 2) {
+            return;
+        }
+    } else if (ctx->compositing_mode == GCompOpAssignInverted) {
+        source.argb = ~source.argb;
+    }
+    source.a = 3;
+    put_pixel(ctx, x, y, source);
+    #endif
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+    if (ctx->frame_buffer_captured) {
+        return NULL;
+    }
+    ctx->frame_buffer_captured = true;
+    memcpy(captured_pixels, ctx->frame_buffer->data, SCREEN_ROW_SIZE * SCREEN_HEIGHT);
+    return ctx->frame_buffer;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+    if (!ctx->frame_buffer_captured || buffer != ctx->frame_buffer) {
+        return false;
+    }
+    ctx->frame_buffer_captured = false;
+
+    long changed = 0;
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            #ifdef PBL_BW
+            int index = y * SCREEN_ROW_SIZE + x / 8;
+            changed += ((captured_pixels[index] ^ buffer->data[index]) >> (x % 8)) & 1;
+            #else
+            int index = y * SCREEN_ROW_SIZE + x;
+            changed += captured_pixels[index] != buffer->data[index];
+            #endif
+        }
+    }
+    if (changed) {
+        step_draws++;
+        step_pixels += changed;
+    }
+    return true;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+    ctx->fill_color = color;
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+    ctx->stroke_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+    ctx->text_color = color;
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+    ctx->compositing_mode = mode;
+}
+
+void graphics_context_set_antialiased(GContext *ctx, bool enable) {
+}
+
+// Pixel (x, y) of `rect` with its corners rounded by `radius`.
+static bool in_round_rect(GRect rect, int radius, GCornerMask corners, int x, int y) {
+    if (x < rect.origin.x || y < rect.origin.y
+            || x >= rect.origin.x + rect.size.w || y >= rect.origin.y + rect.size.h) {
+        return false;
+    }
+    int left = rect.origin.x + radius;
+    int right = rect.origin.x + rect.size.w - 1 - radius;
+    int top = rect.origin.y + radius;
+    int bottom = rect.origin.y + rect.size.h - 1 - radius;
+
+    int corner = 0;
+    int cx = 0, cy = 0;
+    if (x < left && y < top) {
+        corner = GCornerTopLeft, cx = left, cy = top;
+    } else if (x > right && y < top) {
+        corner = GCornerTopRight, cx = right, cy = top;
+    } else if (x < left && y > bottom) {
+        corner = GCornerBottomLeft, cx = left, cy = bottom;
+    } else if (x > right && y > bottom) {
+        corner = GCornerBottomRight, cx = right, cy = bottom;
+    }
+    if (!(corners & corner)) {
+        return true;
+    }
+    int dx = x - cx;
+    int dy = y - cy;
+    return dx * dx + dy * dy <= radius * radius + radius;
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+    step_draws++;
+    for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; y++) {
+        for (int x = rect.origin.x; x < rect.origin.x + rect.size.w; x++) {
+            if (in_round_rect(rect, corner_radius, corner_mask, x, y)) {
+                put_pixel(ctx, x, y, ctx->fill_color);
+            }
+        }
+    }
+}
+
+// Outlines are the pixels of the shape next to one outside it.
+static void stroke_round_rect(GContext *ctx, GRect rect, int radius) {
+    step_draws++;
+    for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; y++) {
+        for (int x = rect.origin.x; x < rect.origin.x + rect.size.w; x++) {
+            if (in_round_rect(rect, radius, GCornersAll, x, y)
+                    && (!in_round_rect(rect, radius, GCornersAll, x - 1, y)
+                        || !in_round_rect(rect, radius, GCornersAll, x + 1, y)
+                        || !in_round_rect(rect, radius, GCornersAll, x, y - 1)
+                        || !in_round_rect(rect, radius, GCornersAll, x, y + 1))) {
+                put_pixel(ctx, x, y, ctx->stroke_color);
+            }
+        }
+    }
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+    stroke_round_rect(ctx, rect, 0);
+}
+
+void graphics_draw_round_rect(GContext *ctx, GRect rect, uint16_t radius) {
+    stroke_round_rect(ctx, rect, radius);
+}
+
+// Bitmaps smaller than the rect are tiled, as on the watch.
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+    if (!bitmap) {
+        return;
+    }
+    step_draws++;
+    for (int y = 0; y < rect.size.h; y++) {
+        for (int x = 0; x < rect.size.w; x++) {
+            GColor source = bitmap_pixel(bitmap, x % bitmap->size.w, y % bitmap->size.h);
+            put_bitmap_pixel(ctx, rect.origin.x + x, rect.origin.y + y, source);
+        }
+    }
+}
+
+// Ring `inset` pixels thick inside the circle fitted in `rect`, from
+// angle_start to angle_end clockwise from 12 o'clock.
+void graphics_fill_radial(GContext *ctx, GRect rect, GOvalScaleMode scale_mode, uint16_t inset,
+                          int32_t angle_start, int32_t angle_end) {
+    step_draws++;
+    int diameter = rect.size.w < rect.size.h ? rect.size.w : rect.size.h;
+    if (scale_mode == GOvalScaleModeFillCircle) {
+        diameter = rect.size.w > rect.size.h ? rect.size.w : rect.size.h;
+    }
+    double outer = diameter / 2.0;
+    double inner = outer - inset;
+    double cx = rect.origin.x + rect.size.w / 2.0;
+    double cy = rect.origin.y + rect.size.h / 2.0;
+    bool full = angle_end - angle_start >= TRIG_MAX_ANGLE;
+
+    for (int y = (int)floor(cy - outer); y < (int)ceil(cy + outer); y++) {
+        for (int x = (int)floor(cx - outer); x < (int)ceil(cx + outer); x++) {
+            double dx = x + 0.5 - cx;
+            double dy = y + 0.5 - cy;
+            double distance = sqrt(dx * dx + dy * dy);
+            if (distance >= outer || distance < inner) {
+                continue;
+            }
+            double angle = atan2(dx, -dy);
+            if (angle < 0) {
+                angle += 2 * M_PI;
+            }
+            int32_t trig_angle = (int32_t)(angle * TRIG_MAX_ANGLE / (2 * M_PI));
+            if (full || (trig_angle >= angle_start && trig_angle < angle_end)) {
+                put_pixel(ctx, x, y, ctx->fill_color);
+            }
+        }
+    }
+}
+
+// Text: greedy word wrap on spaces and newlines, words wider than the
+// box are broken anywhere. Lines are font size high.
+
+#define MAX_TEXT_LINES 16
+
+typedef struct {
+    const char *start;
+    int length;
+} TextLine;
+
+static int text_width(GFont font, int length) {
+    return length * glyph_advance(font);
+}
+
+static int layout_text(const char *text, GFont font, int width, TextLine *lines) {
+    int count = 0;
+    int per_line = width / glyph_advance(font);
+    if (per_line < 1) {
+        per_line = 1;
+    }
+
+    const char *c = text;
+    while (*c && count < MAX_TEXT_LINES) {
+        const char *start = c;
+        const char *line_end = c;
+        const char *next = c;
+        while (*c && *c != '\n' && c - start < per_line) {
+            c++;
+            if (*c == ' ' || *c == '\n' || *c == '\0') {
+                line_end = c;
+                next = c;
+            }
+        }
+        if (*c == '\n' || *c == '\0') {
+            line_end = c;
+            next = *c ? c + 1 : c;
+        } else if (line_end == start) {
+            // one word wider than the box
+            line_end = c;
+            next = c;
+        } else {
+            while (*next == ' ') {
+                next++;
+            }
+        }
+        lines[count].start = start;
+        lines[count].length = line_end - start;
+        count++;
+        c = next;
+    }
+    return count;
+}
+
+static void draw_glyph(GContext *ctx, GFont font, char c, int x0, int y0) {
+    if (c < GLYPH_FIRST || c > GLYPH_LAST) {
+        c = '?';
+    }
+    const uint8_t *rows = GLYPHS[c - GLYPH_FIRST];
+    int advance = glyph_advance(font);
+    for (int y = 0; y < font->size; y++) {
+        uint8_t row = rows[y * GLYPH_HEIGHT / font->size];
+        for (int x = 0; x < advance; x++) {
+            int bit = 0x20 >> (x * GLYPH_WIDTH / advance);
+            int left = x > 0 ? 0x20 >> ((x - 1) * GLYPH_WIDTH / advance) : 0;
+            // bold is struck twice, one pixel apart
+            if ((row & bit) || (font->bold && (row & left))) {
+                put_pixel(ctx, x0 + x, y0 + y, ctx->text_color);
+            }
+        }
+    }
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow_mode, GTextAlignment alignment,
+                        GTextAttributes *text_attributes) {
+    if (!text || !font) {
+        return;
+    }
+    step_draws++;
+    TextLine lines[MAX_TEXT_LINES];
+    int count = layout_text(text, font, box.size.w, lines);
+    for (int i = 0; i < count; i++) {
+        int y = box.origin.y + i * font->size;
+        // lines below the box are dropped, except the first one
+        if (i > 0 && y + font->size > box.origin.y + box.size.h) {
+            break;
+        }
+        int width = text_width(font, lines[i].length);
+        int x = box.origin.x;
+        if (alignment == GTextAlignmentCenter) {
+            x += (box.size.w - width) / 2;
+        } else if (alignment == GTextAlignmentRight) {
+            x += box.size.w - width;
+        }
+        for (int j = 0; j < lines[i].length; j++) {
+            draw_glyph(ctx, font, lines[i].start[j], x + j * glyph_advance(font), y);
+        }
+    }
+}
+
+GSize graphics_text_layout_get_content_size(const char *text, GFont font, GRect box,
+                                            GTextOverflowMode overflow_mode, GTextAlignment alignment) {
+    TextLine lines[MAX_TEXT_LINES];
+    int count = layout_text(text, font, box.size.w, lines);
+    int width = 0;
+    for (int i = 0; i < count; i++) {
+        int line_width = text_width(font, lines[i].length);
+        width = line_width > width ? line_width : width;
+    }
+    return GSize(width, count * font->size);
+}
+
+// Layers
+
+typedef enum {
+    LayerKindPlain,
+    LayerKindText,
+    LayerKindBitmap,
+} LayerKind;
+
+typedef struct {
+    const char *text;
+    GFont font;
+    GColor text_color;
+    GColor background_color;
+    GTextAlignment alignment;
+    GTextOverflowMode overflow_mode;
+} TextLayerData;
+
+typedef struct {
+    const GBitmap *bitmap;
+    GAlign alignment;
+    GColor background_color;
+    GCompOp compositing_mode;
+} BitmapLayerData;
+
+struct Layer {
+    GRect frame;
+    GRect bounds;
+    bool hidden;
+    LayerKind kind;
+    LayerUpdateProc update_proc;
+    Layer *parent;
+    Layer *first_child;
+    Layer *next_sibling;
+    Window *window;
+    union {
+        TextLayerData text;
+        BitmapLayerData bitmap;
+    };
+    uint8_t data[];
+};
+
+struct Window {
+    Layer *root_layer;
+    GColor background_color;
+};
+
+static Window *top_window;
+// something changed since the last redraw
+static bool screen_dirty;
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+    Layer *layer = calloc(1, sizeof(Layer) + data_size);
+    layer->frame = frame;
+    layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+    return layer;
+}
+
+Layer *layer_create(GRect frame) {
+    return layer_create_with_data(frame, 0);
+}
+
+void layer_destroy(Layer *layer) {
+    if (!layer) {
+        return;
+    }
+    layer_remove_from_parent(layer);
+    // children stay alive, without a parent
+    for (Layer *child = layer->first_child; child; ) {
+        Layer *next = child->next_sibling;
+        child->parent = NULL;
+        child->next_sibling = NULL;
+        child = next;
+    }
+    free(layer);
+}
+
+void *layer_get_data(const Layer *layer) {
+    return (void *)layer->data;
+}
+
+void layer_mark_dirty(Layer *layer) {
+    screen_dirty = true;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+    layer->update_proc = update_proc;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+    layer->frame = frame;
+    layer->bounds.size = frame.size;
+    layer_mark_dirty(layer);
+}
+
+GRect layer_get_frame(const Layer *layer) {
+    return layer->frame;
+}
+
+void layer_set_bounds(Layer *layer, GRect bounds) {
+    layer->bounds = bounds;
+    layer_mark_dirty(layer);
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+    return layer->bounds;
+}
+
+static int obstruction_height = 0;
+
+// The bounds minus the part of the screen under the obstruction.
+GRect layer_get_unobstructed_bounds(const Layer *layer) {
+    GPoint origin = GPointZero;
+    for (const Layer *l = layer; l; l = l->parent) {
+        origin.x += l->frame.origin.x + l->bounds.origin.x;
+        origin.y += l->frame.origin.y + l->bounds.origin.y;
+    }
+    GRect unobstructed = GRect(-origin.x, -origin.y, SCREEN_WIDTH, SCREEN_HEIGHT - obstruction_height);
+    return grect_intersection(layer->bounds, unobstructed);
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+    if (layer->hidden != hidden) {
+        layer->hidden = hidden;
+        layer_mark_dirty(layer);
+    }
+}
+
+bool layer_get_hidden(const Layer *layer) {
+    return layer->hidden;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+    layer_remove_from_parent(child);
+    child->parent = parent;
+    Layer **link = &parent->first_child;
+    while (*link) {
+        link = &(*link)->next_sibling;
+    }
+    *link = child;
+    layer_mark_dirty(parent);
+}
+
+void layer_remove_from_parent(Layer *child) {
+    if (!child->parent) {
+        return;
+    }
+    for (Layer **link = &child->parent->first_child; *link; link = &(*link)->next_sibling) {
+        if (*link == child) {
+            *link = child->next_sibling;
+            break;
+        }
+    }
+    child->parent = NULL;
+    child->next_sibling = NULL;
+    screen_dirty = true;
+}
+
+Window *layer_get_window(const Layer *layer) {
+    while (layer->parent) {
+        layer = layer->parent;
+    }
+    return layer->window;
+}
+
+static void text_layer_update_proc(Layer *layer, GContext *ctx) {
+    TextLayerData *data = &layer->text;
+    GRect bounds = GRect(0, 0, layer->bounds.size.w, layer->bounds.size.h);
+    if (data->background_color.a) {
+        graphics_context_set_fill_color(ctx, data->background_color);
+        graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+    }
+    if (data->text && *data->text) {
+        graphics_context_set_text_color(ctx, data->text_color);
+        graphics_draw_text(ctx, data->text, data->font, bounds, data->overflow_mode, data->alignment, NULL);
+    }
+}
+
+TextLayer *text_layer_create(GRect frame) {
+    TextLayer *text_layer = layer_create(frame);
+    text_layer->kind = LayerKindText;
+    text_layer->update_proc = text_layer_update_proc;
+    text_layer->text = (TextLayerData){
+        .text = NULL,
+        .font = fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
+        .text_color = GColorBlack,
+        .background_color = GColorWhite,
+        .alignment = GTextAlignmentLeft,
+        .overflow_mode = GTextOverflowModeWordWrap,
+    };
+    return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+    layer_destroy(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+    return text_layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+    text_layer->text.text = text;
+    layer_mark_dirty(text_layer);
+}
+
+const char *text_layer_get_text(TextLayer *text_layer) {
+    return text_layer->text.text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+    text_layer->text.background_color = color;
+    layer_mark_dirty(text_layer);
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+    text_layer->text.text_color = color;
+    layer_mark_dirty(text_layer);
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+    text_layer->text.font = font;
+    layer_mark_dirty(text_layer);
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+    text_layer->text.alignment = text_alignment;
+    layer_mark_dirty(text_layer);
+}
+
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode line_mode) {
+    text_layer->text.overflow_mode = line_mode;
+    layer_mark_dirty(text_layer);
+}
+
+static GRect align_rect(GSize size, GRect box, GAlign alignment) {
+    int left = box.origin.x;
+    int center_x = box.origin.x + (box.size.w - size.w) / 2;
+    int right = box.origin.x + box.size.w - size.w;
+    int top = box.origin.y;
+    int center_y = box.origin.y + (box.size.h - size.h) / 2;
+    int bottom = box.origin.y + box.size.h - size.h;
+
+    switch (alignment) {
+    case GAlignTopLeft:
+        return GRect(left, top, size.w, size.h);
+    case GAlignTopRight:
+        return GRect(right, top, size.w, size.h);
+    case GAlignTop:
+        return GRect(center_x, top, size.w, size.h);
+    case GAlignLeft:
+        return GRect(left, center_y, size.w, size.h);
+    case GAlignBottom:
+        return GRect(center_x, bottom, size.w, size.h);
+    case GAlignRight:
+        return GRect(right, center_y, size.w, size.h);
+    case GAlignBottomRight:
+        return GRect(right, bottom, size.w, size.h);
+    case GAlignBottomLeft:
+        return GRect(left, bottom, size.w, size.h);
+    default:
+        return GRect(center_x, center_y, size.w, size.h);
+    }
+}
+
+static void bitmap_layer_update_proc(Layer *layer, GContext *ctx) {
+    BitmapLayerData *data = &layer->bitmap;
+    GRect bounds = GRect(0, 0, layer->bounds.size.w, layer->bounds.size.h);
+    if (data->background_color.a) {
+        graphics_context_set_fill_color(ctx, data->background_color);
+        graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+    }
+    if (data->bitmap) {
+        graphics_context_set_compositing_mode(ctx, data->compositing_mode);
+        graphics_draw_bitmap_in_rect(ctx, data->bitmap, align_rect(data->bitmap->size, bounds, data->alignment));
+    }
+}
+
+BitmapLayer *bitmap_layer_create(GRect frame) {
+    BitmapLayer *bitmap_layer = layer_create(frame);
+    bitmap_layer->kind = LayerKindBitmap;
+    bitmap_layer->update_proc = bitmap_layer_update_proc;
+    bitmap_layer->bitmap = (BitmapLayerData){
+        .bitmap = NULL,
+        .alignment = GAlignCenter,
+        .background_color = GColorClear,
+        .compositing_mode = GCompOpAssign,
+    };
+    return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer) {
+    layer_destroy(bitmap_layer);
+}
+
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer) {
+    return (Layer *)bitmap_layer;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap) {
+    bitmap_layer->bitmap.bitmap = bitmap;
+    layer_mark_dirty(bitmap_layer);
+}
+
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment) {
+    bitmap_layer->bitmap.alignment = alignment;
+    layer_mark_dirty(bitmap_layer);
+}
+
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer, GColor color) {
+    bitmap_layer->bitmap.background_color = color;
+    layer_mark_dirty(bitmap_layer);
+}
+
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode) {
+    bitmap_layer->bitmap.compositing_mode = mode;
+    layer_mark_dirty(bitmap_layer);
+}
+
+Window *window_create(void) {
+    Window *window = calloc(1, sizeof(Window));
+    window->root_layer = layer_create(GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT));
+    window->root_layer->window = window;
+    window->background_color = GColorWhite;
+    return window;
+}
+
+void window_destroy(Window *window) {
+    if (window == top_window) {
+        top_window = NULL;
+    }
+    layer_destroy(window->root_layer);
+    free(window);
+}
+
+Layer *window_get_root_layer(const Window *window) {
+    return window->root_layer;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+    window->background_color = background_color;
+    screen_dirty = true;
+}
+
+void window_stack_push(Window *window, bool animated) {
+    top_window = window;
+    screen_dirty = true;
+}
+
+// Children are drawn over their parent, clipped to every frame above.
+static void render_layer(Layer *layer, GPoint origin, GRect clip) {
+    if (layer->hidden) {
+        return;
+    }
+    GPoint frame_origin = GPoint(origin.x + layer->frame.origin.x, origin.y + layer->frame.origin.y);
+    clip = grect_intersection(clip, (GRect){frame_origin, layer->frame.size});
+    GPoint box_origin = GPoint(frame_origin.x + layer->bounds.origin.x, frame_origin.y + layer->bounds.origin.y);
+
+    if (layer->update_proc && clip.size.w > 0) {
+        context.offset = box_origin;
+        context.clip = clip;
+        context.compositing_mode = GCompOpAssign;
+        context.fill_color = GColorBlack;
+        context.stroke_color = GColorBlack;
+        context.text_color = GColorBlack;
+        layer->update_proc(layer, &context);
+    }
+    for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+        render_layer(child, box_origin, clip);
+    }
+}
+
+static void render(void) {
+    if (!top_window || !screen_dirty) {
+        return;
+    }
+    screen_dirty = false;
+    step_redraws++;
+
+    // the window fills its background first
+    context.offset = GPointZero;
+    context.clip = GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    context.fill_color = top_window->background_color;
+    graphics_fill_rect(&context, context.clip, 0, GCornerNone);
+
+    render_layer(top_window->root_layer, GPointZero, context.clip);
+}
+
+// Animations and timers, on the virtual clock
+
+struct Animation {
+    uint32_t duration;
+    AnimationCurve curve;
+    const AnimationImplementation *implementation;
+    uint64_t started;
+    bool scheduled;
+};
+
+struct AppTimer {
+    uint64_t fires;
+    AppTimerCallback callback;
+    void *data;
+    bool pending;
+    AppTimer *next;
+};
+
+static AppTimer *timers;
+static Animation *running_animation;
+
+Animation *animation_create(void) {
+    Animation *animation = calloc(1, sizeof(Animation));
+    animation->duration = 250;
+    animation->curve = AnimationCurveEaseInOut;
+    return animation;
+}
+
+bool animation_destroy(Animation *animation) {
+    if (running_animation == animation) {
+        running_animation = NULL;
+    }
+    free(animation);
+    return true;
+}
+
+bool animation_set_duration(Animation *animation, uint32_t duration_ms) {
+    animation->duration = duration_ms;
+    return true;
+}
+
+bool animation_set_curve(Animation *animation, AnimationCurve curve) {
+    animation->curve = curve;
+    return true;
+}
+
+bool animation_set_implementation(Animation *animation, const AnimationImplementation *implementation) {
+    animation->implementation = implementation;
+    return true;
+}
+
+// One animation at a time is all the faces run.
+bool animation_schedule(Animation *animation) {
+    if (running_animation && running_animation != animation) {
+        animation_unschedule(running_animation);
+    }
+    animation->started = clock_ms;
+    animation->scheduled = true;
+    running_animation = animation;
+    if (animation->implementation && animation->implementation->setup) {
+        animation->implementation->setup(animation);
+    }
+    return true;
+}
+
+// Like on the watch, an unscheduled animation is torn down and freed.
+bool animation_unschedule(Animation *animation) {
+    if (!animation || !animation->scheduled) {
+        return false;
+    }
+    animation->scheduled = false;
+    if (running_animation == animation) {
+        running_animation = NULL;
+    }
+    if (animation->implementation && animation->implementation->teardown) {
+        animation->implementation->teardown(animation);
+    }
+    free(animation);
+    return true;
+}
+
+static AnimationProgress curve_progress(AnimationCurve curve, double t) {
+    switch (curve) {
+    case AnimationCurveEaseIn:
+        t = t * t;
+        break;
+    case AnimationCurveEaseOut:
+        t = 1 - (1 - t) * (1 - t);
+        break;
+    case AnimationCurveEaseInOut:
+        t = t < 0.5 ? 2 * t * t : 1 - 2 * (1 - t) * (1 - t);
+        break;
+    default:
+        break;
+    }
+    return (AnimationProgress)lround(t * ANIMATION_NORMALIZED_MAX);
+}
+
+static void step_animation(void) {
+    Animation *animation = running_animation;
+    double t = animation->duration ? (double)(clock_ms - animation->started) / animation->duration : 1;
+    if (t > 1) {
+        t = 1;
+    }
+    if (animation->implementation && animation->implementation->update) {
+        animation->implementation->update(animation, curve_progress(animation->curve, t));
+    }
+    if (t >= 1 && running_animation == animation) {
+        animation_unschedule(animation);
+    }
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+    AppTimer *timer = calloc(1, sizeof(AppTimer));
+    timer->fires = clock_ms + timeout_ms;
+    timer->callback = callback;
+    timer->data = callback_data;
+    timer->pending = true;
+    timer->next = timers;
+    timers = timer;
+    return timer;
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+    if (!timer_handle->pending) {
+        return false;
+    }
+    timer_handle->fires = clock_ms + new_timeout_ms;
+    return true;
+}
+
+// Fired and cancelled timers are kept, so stale handles stay harmless.
+void app_timer_cancel(AppTimer *timer_handle) {
+    timer_handle->pending = false;
+}
+
+static AppTimer *next_timer(void) {
+    AppTimer *next = NULL;
+    for (AppTimer *timer = timers; timer; timer = timer->next) {
+        if (timer->pending && (!next || timer->fires < next->fires)) {
+            next = timer;
+        }
+    }
+    return next;
+}
+
+// Runs timers and animation frames up to `until`, redrawing after each
+// event that dirtied the screen.
+static void run_until(uint64_t until) {
+    for (;;) {
+        AppTimer *timer = next_timer();
+        uint64_t frame = running_animation ? clock_ms + ANIMATION_FRAME_MS : UINT64_MAX;
+        if (timer && timer->fires <= until && timer->fires <= frame) {
+            if (timer->fires > clock_ms) {
+                clock_ms = timer->fires;
+            }
+            timer->pending = false;
+            timer->callback(timer->data);
+        } else if (running_animation && frame <= until) {
+            clock_ms = frame;
+            step_animation();
+        } else {
+            break;
+        }
+        render();
+    }
+    if (until > clock_ms) {
+        clock_ms = until;
+    }
+}
+
+// Services: the scene is a connected watch at 40 % battery, then 30 %.
+
+static int step_sums = 0;
+static int battery_percent = SCENE_BATTERY_PERCENT;
+
+static TickHandler tick_handler;
+static BatteryStateHandler battery_handler;
+static UnobstructedAreaHandlers unobstructed_handlers;
+static void *unobstructed_context;
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+    tick_handler = handler;
+}
+
+void tick_timer_service_unsubscribe(void) {
+    tick_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+    return (BatteryChargeState){
+        .charge_percent = battery_percent,
+        .is_charging = false,
+        .is_plugged = false,
+    };
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+    battery_handler = handler;
+}
+
+void battery_state_service_unsubscribe(void) {
+    battery_handler = NULL;
+}
+
+bool bluetooth_connection_service_peek(void) {
+    return true;
+}
+
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler) {
+}
+
+void bluetooth_connection_service_unsubscribe(void) {
+}
+
+void app_focus_service_subscribe(AppFocusHandler handler) {
+}
+
+void app_focus_service_unsubscribe(void) {
+}
+
+void accel_tap_service_subscribe(AccelTapHandler handler) {
+}
+
+void accel_tap_service_unsubscribe(void) {
+}
+
+void vibes_long_pulse(void) {
+}
+
+void vibes_short_pulse(void) {
+}
+
+void vibes_enqueue_custom_pattern(VibePattern pattern) {
+}
+
+bool health_service_events_subscribe(HealthEventHandler handler, void *context) {
+    return true;
+}
+
+bool health_service_events_unsubscribe(void) {
+    return true;
+}
+
+HealthValue health_service_sum_today(HealthMetric metric) {
+    step_sums++;
+    return metric == HealthMetricStepCount ? SCENE_STEPS : 0;
+}
+
+void unobstructed_area_service_subscribe(UnobstructedAreaHandlers handlers, void *context) {
+    unobstructed_handlers = handlers;
+    unobstructed_context = context;
+}
+
+void unobstructed_area_service_unsubscribe(void) {
+    memset(&unobstructed_handlers, 0, sizeof(unobstructed_handlers));
+}
+
+size_t heap_bytes_used(void) {
+    return 0;
+}
+
+size_t heap_bytes_free(void) {
+    return 24 * 1024;
+}
+
+// Persistent storage, in memory
+
+typedef struct {
+    bool used;
+    uint32_t key;
+    int size;
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+#define MAX_PERSIST_ENTRIES 32
+
+static PersistEntry persist_entries[MAX_PERSIST_ENTRIES];
+
+static PersistEntry *persist_find(uint32_t key, bool create) {
+    PersistEntry *free_entry = NULL;
+    for (int i = 0; i < MAX_PERSIST_ENTRIES; i++) {
+        if (persist_entries[i].used && persist_entries[i].key == key) {
+            return &persist_entries[i];
+        }
+        if (!persist_entries[i].used && !free_entry) {
+            free_entry = &persist_entries[i];
+        }
+    }
+    if (!create || !free_entry) {
+        return NULL;
+    }
+    free_entry->used = true;
+    free_entry->key = key;
+    return free_entry;
+}
+
+bool persist_exists(const uint32_t key) {
+    return persist_find(key, false) != NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+    PersistEntry *entry = persist_find(key, false);
+    return entry ? entry->size : E_DOES_NOT_EXIST;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+    PersistEntry *entry = persist_find(key, false);
+    if (!entry) {
+        return E_DOES_NOT_EXIST;
+    }
+    int size = (size_t)entry->size < buffer_size ? entry->size : (int)buffer_size;
+    memcpy(buffer, entry->data, size);
+    return size;
+}
+
+bool persist_read_bool(const uint32_t key) {
+    bool value = false;
+    persist_read_data(key, &value, sizeof(value));
+    return value;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+    int32_t value = 0;
+    persist_read_data(key, &value, sizeof(value));
+    return value;
+}
+
+int persist_read_string(const uint32_t key, char *buffer, const size_t buffer_size) {
+    int size = persist_read_data(key, buffer, buffer_size);
+    if (size > 0) {
+        buffer[size - 1] = '\0';
+    }
+    return size;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+    if (size > PERSIST_DATA_MAX_LENGTH) {
+        return E_INVALID_ARGUMENT;
+    }
+    PersistEntry *entry = persist_find(key, true);
+    if (!entry) {
+        return E_ERROR;
+    }
+    memcpy(entry->data, data, size);
+    entry->size = size;
+    return size;
+}
+
+status_t persist_write_bool(const uint32_t key, const bool value) {
+    return persist_write_data(key, &value, sizeof(value)) < 0 ? E_ERROR : S_SUCCESS;
+}
+
+status_t persist_write_int(const uint32_t key, const int32_t value) {
+    return persist_write_data(key, &value, sizeof(value)) < 0 ? E_ERROR : S_SUCCESS;
+}
+
+int persist_write_string(const uint32_t key, const char *cstring) {
+    return persist_write_data(key, cstring, strlen(cstring) + 1);
+}
+
+status_t persist_delete(const uint32_t key) {
+    PersistEntry *entry = persist_find(key, false);
+    if (!entry) {
+        return E_DOES_NOT_EXIST;
+    }
+    entry->used = false;
+    return S_SUCCESS;
+}
+
+// App messages: opening and sending work, nothing ever arrives.
+
+struct __attribute__((__packed__)) Dictionary {
+    uint8_t count;
+    Tuple head[];
+};
+
+#define TUPLE_HEADER_SIZE 7
+
+static uint8_t outbox[APP_MESSAGE_OUTBOX_SIZE_MINIMUM];
+static DictionaryIterator outbox_iterator;
+static int messages_sent = 0;
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+    return APP_MSG_OK;
+}
+
+void app_message_deregister_callbacks(void) {
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+    return NULL;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+    return NULL;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+    return NULL;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+    return NULL;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+    memset(outbox, 0, sizeof(outbox));
+    outbox_iterator.dictionary = (Dictionary *)outbox;
+    outbox_iterator.cursor = outbox_iterator.dictionary->head;
+    outbox_iterator.end = outbox + sizeof(outbox);
+    *iterator = &outbox_iterator;
+    return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+    messages_sent++;
+    return APP_MSG_OK;
+}
+
+static Tuple *next_tuple(Tuple *tuple) {
+    return (Tuple *)((uint8_t *)tuple + TUPLE_HEADER_SIZE + tuple->length);
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+    Tuple *tuple = iter->dictionary->head;
+    for (int i = 0; i < iter->dictionary->count; i++, tuple = next_tuple(tuple)) {
+        if (tuple->key == key) {
+            return tuple;
+        }
+    }
+    return NULL;
+}
+
+uint32_t dict_size(DictionaryIterator *iter) {
+    return (uint8_t *)iter->cursor - (uint8_t *)iter->dictionary;
+}
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...) {
+    uint32_t size = sizeof(Dictionary) + tuple_count * TUPLE_HEADER_SIZE;
+    va_list sizes;
+    va_start(sizes, tuple_count);
+    for (int i = 0; i < tuple_count; i++) {
+        size += va_arg(sizes, uint32_t);
+    }
+    va_end(sizes);
+    return size;
+}
+
+static DictionaryResult dict_write(DictionaryIterator *iter, uint32_t key, TupleType type,
+                                   const void *data, uint16_t length) {
+    if ((uint8_t *)iter->cursor + TUPLE_HEADER_SIZE + length > (uint8_t *)iter->end) {
+        return DICT_NOT_ENOUGH_STORAGE;
+    }
+    iter->cursor->key = key;
+    iter->cursor->type = type;
+    iter->cursor->length = length;
+    memcpy(iter->cursor->value->data, data, length);
+    iter->cursor = next_tuple(iter->cursor);
+    iter->dictionary->count++;
+    return DICT_OK;
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) {
+    return dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) {
+    return dict_write(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char *cstring) {
+    return dict_write(iter, key, TUPLE_CSTRING, cstring, strlen(cstring) + 1);
+}
+
+// The scene
+
+static const char *out_dir;
+
+static void write_frame(const char *name) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.ppm", out_dir, name);
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "can't write %s\n", path);
+        exit(1);
+    }
+    fprintf(file, "P6\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            uint8_t rgb[3] = {0, 0, 0};
+            #ifdef PBL_BW
+            if (frame_buffer_bit(x, y)) {
+                rgb[0] = rgb[1] = rgb[2] = 255;
+            }
+            #else
+            // pixels off the round display stay black
+            if (on_screen(x, y)) {
+                GColor color = {.argb = context.frame_buffer->data[y * SCREEN_ROW_SIZE + x]};
+                rgb[0] = color.r * 85;
+                rgb[1] = color.g * 85;
+                rgb[2] = color.b * 85;
+            }
+            #endif
+            fwrite(rgb, 1, sizeof(rgb), file);
+        }
+    }
+    fclose(file);
+}
+
+static void begin_step(void) {
+    step_redraws = 0;
+    step_draws = 0;
+    step_pixels = 0;
+}
+
+static void end_step(const char *name) {
+    printf("frame %s: %d redraws, %d draws, %ld px\n", name, step_redraws, step_draws, step_pixels);
+    write_frame(name);
+}
+
+// Settles the zero delay timers of the last event, and any animation.
+static void settle(void) {
+    run_until(clock_ms);
+    while (running_animation) {
+        run_until(clock_ms + ANIMATION_FRAME_MS);
+    }
+}
+
+// Storage as left by earlier runs, and the clock, before main() starts.
+__attribute__((constructor))
+static void scene_init(void) {
+    setenv("TZ", "UTC", 1);
+    tzset();
+    out_dir = getenv("HEADLESS_OUT") ? getenv("HEADLESS_OUT") : ".";
+
+    const char *style = getenv("HEADLESS_STYLE");
+    persist_write_bool(STYLE_KEY, style && strcmp(style, "inverse") == 0);
+    #ifdef TERMO_KEY
+    // weather from ten minutes ago, with a condition icon
+    persist_write_string(TERMO_KEY, "+3.5C");
+    persist_write_int(TERMO_TS_KEY, SCENE_START - 600);
+    persist_write_int(TERMO_CONDITION_KEY, 2);
+    #endif
+    #ifdef LOCATION_KEY
+    // Moscow, in hundredths of a degree
+    int32_t location[2] = {5575, 3762};
+    persist_write_data(LOCATION_KEY, location, sizeof(location));
+    #endif
+
+    #ifdef STEPS_SNAPSHOT_KEY
+    // steps shown when the face last ran, earlier today
+    struct {
+        time_t day;
+        int32_t bucket;
+    } steps = {time_start_of_today(), 51};
+    persist_write_data(STEPS_SNAPSHOT_KEY, &steps, sizeof(steps));
+    #endif
+
+    frame_buffer_init();
+    begin_step();
+}
+
+void app_event_loop(void) {
+    // init ran in main() before this, in the launch step
+    if (step_sums) {
+        fprintf(stderr, "%d step sums in init\n", step_sums);
+    }
+    settle();
+    render();
+    end_step("launch");
+
+    begin_step();
+    clock_ms += 60 * 1000;
+    if (tick_handler) {
+        time_t now = time(NULL);
+        tick_handler(localtime(&now), MINUTE_UNIT);
+    }
+    battery_percent = SCENE_TICK_BATTERY_PERCENT;
+    if (battery_handler) {
+        battery_handler(battery_state_service_peek());
+    }
+    render();
+    settle();
+    end_step("tick");
+
+    #ifndef PBL_ROUND
+    begin_step();
+    obstruction_height = SCENE_PEEK_HEIGHT;
+    GRect area = GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT - obstruction_height);
+    if (unobstructed_handlers.will_change) {
+        unobstructed_handlers.will_change(area, unobstructed_context);
+    }
+    if (unobstructed_handlers.change) {
+        unobstructed_handlers.change(ANIMATION_NORMALIZED_MAX, unobstructed_context);
+    }
+    if (unobstructed_handlers.did_change) {
+        unobstructed_handlers.did_change(unobstructed_context);
+    }
+    render();
+    settle();
+    end_step("peek");
+    #endif
+
+    if (messages_sent) {
+        fprintf(stderr, "%d messages sent\n", messages_sent);
+    }
+}
@@ -0,0 +1,589 @@
+// Stand-in for the Pebble SDK header, for the headless render harness
+// (see buildtools/render.py). It declares the part of the SDK 3 API the
+// faces use, with the same names, types and constants, so lib/ compiles
+// unchanged on Linux against the software rasterizer in pebble.c.
+#ifndef HEADLESS_PEBBLE_H
+#define HEADLESS_PEBBLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// generated per variant and platform by render.py
+#include "message_keys.auto.h"
+#include "resource_ids.auto.h"
+
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+#if defined(PBL_PLATFORM_CHALK)
+#define PBL_DISPLAY_WIDTH 180
+#define PBL_DISPLAY_HEIGHT 180
+#elif defined(PBL_PLATFORM_EMERY)
+#define PBL_DISPLAY_WIDTH 200
+#define PBL_DISPLAY_HEIGHT 228
+#else
+#define PBL_DISPLAY_WIDTH 144
+#define PBL_DISPLAY_HEIGHT 168
+#endif
+
+#ifdef PBL_ROUND
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_false)
+#else
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_true)
+#endif
+
+#ifdef PBL_COLOR
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_false)
+#else
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_true)
+#endif
+
+// Logging
+
+typedef enum {
+    APP_LOG_LEVEL_ERROR = 1,
+    APP_LOG_LEVEL_WARNING = 50,
+    APP_LOG_LEVEL_INFO = 100,
+    APP_LOG_LEVEL_DEBUG = 200,
+    APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+} AppLogLevel;
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+#define APP_LOG(level, fmt, ...) app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+// Geometry
+
+typedef struct GPoint {
+    int16_t x;
+    int16_t y;
+} GPoint;
+
+typedef struct GSize {
+    int16_t w;
+    int16_t h;
+} GSize;
+
+typedef struct GRect {
+    GPoint origin;
+    GSize size;
+} GRect;
+
+typedef struct GEdgeInsets {
+    int16_t top;
+    int16_t right;
+    int16_t bottom;
+    int16_t left;
+} GEdgeInsets;
+
+#define GPoint(x, y) ((GPoint){(x), (y)})
+#define GPointZero GPoint(0, 0)
+#define GSize(w, h) ((GSize){(w), (h)})
+#define GSizeZero GSize(0, 0)
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+#define GRectZero GRect(0, 0, 0, 0)
+#define GEdgeInsets1(value) ((GEdgeInsets){(value), (value), (value), (value)})
+#define GEdgeInsets2(vertical, horizontal) ((GEdgeInsets){(vertical), (horizontal), (vertical), (horizontal)})
+#define GEdgeInsets4(top, right, bottom, left) ((GEdgeInsets){(top), (right), (bottom), (left)})
+#define GEdgeInsetsN(_1, _2, _3, _4, NAME, ...) NAME
+#define GEdgeInsets(...) GEdgeInsetsN(__VA_ARGS__, GEdgeInsets4, GEdgeInsets3, GEdgeInsets2, GEdgeInsets1)(__VA_ARGS__)
+
+bool gpoint_equal(const GPoint *point_a, const GPoint *point_b);
+bool gsize_equal(const GSize *size_a, const GSize *size_b);
+bool grect_equal(const GRect *rect_a, const GRect *rect_b);
+GRect grect_inset(GRect rect, GEdgeInsets insets);
+
+// Colors
+
+typedef union GColor8 {
+    uint8_t argb;
+    struct {
+        uint8_t b:2;
+        uint8_t g:2;
+        uint8_t r:2;
+        uint8_t a:2;
+    };
+} GColor8;
+
+typedef GColor8 GColor;
+
+bool gcolor_equal(GColor8 color_a, GColor8 color_b);
+
+#define GColorARGB8(a, r, g, b) ((uint8_t)(((a) << 6) | ((r) << 4) | ((g) << 2) | (b)))
+
+#define GColorClearARGB8 GColorARGB8(0, 0, 0, 0)
+#define GColorBlackARGB8 GColorARGB8(3, 0, 0, 0)
+#define GColorOxfordBlueARGB8 GColorARGB8(3, 0, 0, 1)
+#define GColorDukeBlueARGB8 GColorARGB8(3, 0, 0, 2)
+#define GColorBlueARGB8 GColorARGB8(3, 0, 0, 3)
+#define GColorDarkGreenARGB8 GColorARGB8(3, 0, 1, 0)
+#define GColorJaegerGreenARGB8 GColorARGB8(3, 0, 2, 1)
+#define GColorGreenARGB8 GColorARGB8(3, 0, 3, 0)
+#define GColorCyanARGB8 GColorARGB8(3, 0, 3, 3)
+#define GColorBulgarianRoseARGB8 GColorARGB8(3, 1, 0, 0)
+#define GColorDarkGrayARGB8 GColorARGB8(3, 1, 1, 1)
+#define GColorRedARGB8 GColorARGB8(3, 3, 0, 0)
+#define GColorOrangeARGB8 GColorARGB8(3, 3, 2, 0)
+#define GColorChromeYellowARGB8 GColorARGB8(3, 3, 2, 0)
+#define GColorMelonARGB8 GColorARGB8(3, 3, 2, 2)
+#define GColorLightGrayARGB8 GColorARGB8(3, 2, 2, 2)
+#define GColorMintGreenARGB8 GColorARGB8(3, 2, 3, 2)
+#define GColorYellowARGB8 GColorARGB8(3, 3, 3, 0)
+#define GColorIcterineARGB8 GColorARGB8(3, 3, 3, 1)
+#define GColorPastelYellowARGB8 GColorARGB8(3, 3, 3, 2)
+#define GColorWhiteARGB8 GColorARGB8(3, 3, 3, 3)
+
+#define GColorClear ((GColor8){.argb = GColorClearARGB8})
+#define GColorBlack ((GColor8){.argb = GColorBlackARGB8})
+#define GColorOxfordBlue ((GColor8){.argb = GColorOxfordBlueARGB8})
+#define GColorDukeBlue ((GColor8){.argb = GColorDukeBlueARGB8})
+#define GColorBlue ((GColor8){.argb = GColorBlueARGB8})
+#define GColorDarkGreen ((GColor8){.argb = GColorDarkGreenARGB8})
+#define GColorJaegerGreen ((GColor8){.argb = GColorJaegerGreenARGB8})
+#define GColorGreen ((GColor8){.argb = GColorGreenARGB8})
+#define GColorCyan ((GColor8){.argb = GColorCyanARGB8})
+#define GColorBulgarianRose ((GColor8){.argb = GColorBulgarianRoseARGB8})
+#define GColorDarkGray ((GColor8){.argb = GColorDarkGrayARGB8})
+#define GColorRed ((GColor8){.argb = GColorRedARGB8})
+#define GColorOrange ((GColor8){.argb = GColorOrangeARGB8})
+#define GColorChromeYellow ((GColor8){.argb = GColorChromeYellowARGB8})
+#define GColorMelon ((GColor8){.argb = GColorMelonARGB8})
+#define GColorLightGray ((GColor8){.argb = GColorLightGrayARGB8})
+#define GColorMintGreen ((GColor8){.argb = GColorMintGreenARGB8})
+#define GColorYellow ((GColor8){.argb = GColorYellowARGB8})
+#define GColorIcterine ((GColor8){.argb = GColorIcterineARGB8})
+#define GColorPastelYellow ((GColor8){.argb = GColorPastelYellowARGB8})
+#define GColorWhite ((GColor8){.argb = GColorWhiteARGB8})
+
+// Graphics
+
+typedef enum {
+    GCompOpAssign,
+    GCompOpAssignInverted,
+    GCompOpOr,
+    GCompOpAnd,
+    GCompOpClear,
+    GCompOpSet,
+} GCompOp;
+
+typedef enum {
+    GCornerNone = 0,
+    GCornerTopLeft = 1 << 0,
+    GCornerTopRight = 1 << 1,
+    GCornerBottomLeft = 1 << 2,
+    GCornerBottomRight = 1 << 3,
+    GCornersAll = GCornerTopLeft | GCornerTopRight | GCornerBottomLeft | GCornerBottomRight,
+} GCornerMask;
+
+typedef enum {
+    GAlignCenter,
+    GAlignTopLeft,
+    GAlignTopRight,
+    GAlignTop,
+    GAlignLeft,
+    GAlignBottom,
+    GAlignRight,
+    GAlignBottomRight,
+    GAlignBottomLeft,
+} GAlign;
+
+typedef enum {
+    GTextAlignmentLeft,
+    GTextAlignmentCenter,
+    GTextAlignmentRight,
+} GTextAlignment;
+
+typedef enum {
+    GTextOverflowModeWordWrap,
+    GTextOverflowModeTrailingEllipsis,
+    GTextOverflowModeFill,
+} GTextOverflowMode;
+
+typedef enum {
+    GOvalScaleModeFitCircle,
+    GOvalScaleModeFillCircle,
+} GOvalScaleMode;
+
+typedef enum {
+    GBitmapFormat1Bit,
+    GBitmapFormat8Bit,
+    GBitmapFormat1BitPalette,
+    GBitmapFormat2BitPalette,
+    GBitmapFormat4BitPalette,
+    GBitmapFormat8BitCircular,
+} GBitmapFormat;
+
+typedef struct GBitmap GBitmap;
+typedef struct GContext GContext;
+typedef struct GFontInfo *GFont;
+typedef struct GTextAttributes GTextAttributes;
+
+typedef struct {
+    uint8_t *data;
+    int16_t min_x;
+    int16_t max_x;
+} GBitmapDataRowInfo;
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor *palette,
+                                           bool free_on_destroy);
+void gbitmap_destroy(GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+GColor *gbitmap_get_palette(const GBitmap *bitmap);
+void gbitmap_set_palette(GBitmap *bitmap, GColor *palette, bool free_on_destroy);
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y);
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+void graphics_context_set_antialiased(GContext *ctx, bool enable);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_rect(GContext *ctx, GRect rect);
+void graphics_draw_round_rect(GContext *ctx, GRect rect, uint16_t radius);
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect);
+void graphics_fill_radial(GContext *ctx, GRect rect, GOvalScaleMode scale_mode, uint16_t inset,
+                          int32_t angle_start, int32_t angle_end);
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow_mode, GTextAlignment alignment,
+                        GTextAttributes *text_attributes);
+GSize graphics_text_layout_get_content_size(const char *text, GFont font, GRect box,
+                                            GTextOverflowMode overflow_mode, GTextAlignment alignment);
+GBitmap *graphics_capture_frame_buffer(GContext *ctx);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+
+// Fonts: every system font is drawn with one bitmap font scaled to the
+// font height, so text lands where it would, without the exact glyphs.
+
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_14_BOLD "RESOURCE_ID_GOTHIC_14_BOLD"
+#define FONT_KEY_GOTHIC_18 "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24 "RESOURCE_ID_GOTHIC_24"
+#define FONT_KEY_GOTHIC_24_BOLD "RESOURCE_ID_GOTHIC_24_BOLD"
+#define FONT_KEY_GOTHIC_28 "RESOURCE_ID_GOTHIC_28"
+#define FONT_KEY_GOTHIC_28_BOLD "RESOURCE_ID_GOTHIC_28_BOLD"
+#define FONT_KEY_ROBOTO_CONDENSED_21 "RESOURCE_ID_ROBOTO_CONDENSED_21"
+#define FONT_KEY_ROBOTO_BOLD_SUBSET_49 "RESOURCE_ID_ROBOTO_BOLD_SUBSET_49"
+#define FONT_KEY_BITHAM_42_BOLD "RESOURCE_ID_BITHAM_42_BOLD"
+
+GFont fonts_get_system_font(const char *font_key);
+
+// Trigonometry
+
+#define TRIG_MAX_RATIO 0xffff
+#define TRIG_MAX_ANGLE 0x10000
+#define DEG_TO_TRIGANGLE(angle) (((angle) * TRIG_MAX_ANGLE) / 360)
+#define TRIGANGLE_TO_DEG(trig_angle) (((trig_angle) * 360) / TRIG_MAX_ANGLE)
+
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+int32_t atan2_lookup(int16_t y, int16_t x);
+
+// Layers and windows
+
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef struct Layer TextLayer;
+typedef struct Layer BitmapLayer;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer *layer_create(GRect frame);
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void *layer_get_data(const Layer *layer);
+void layer_mark_dirty(Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_set_frame(Layer *layer, GRect frame);
+GRect layer_get_frame(const Layer *layer);
+void layer_set_bounds(Layer *layer, GRect bounds);
+GRect layer_get_bounds(const Layer *layer);
+GRect layer_get_unobstructed_bounds(const Layer *layer);
+void layer_set_hidden(Layer *layer, bool hidden);
+bool layer_get_hidden(const Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_remove_from_parent(Layer *child);
+Window *layer_get_window(const Layer *layer);
+
+TextLayer *text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer *text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+const char *text_layer_get_text(TextLayer *text_layer);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment);
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode line_mode);
+
+BitmapLayer *bitmap_layer_create(GRect frame);
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer);
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer);
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap);
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment);
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer, GColor color);
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode);
+
+Window *window_create(void);
+void window_destroy(Window *window);
+Layer *window_get_root_layer(const Window *window);
+void window_set_background_color(Window *window, GColor background_color);
+void window_stack_push(Window *window, bool animated);
+
+// Animations
+
+typedef struct Animation Animation;
+typedef uint32_t AnimationProgress;
+
+#define ANIMATION_NORMALIZED_MIN 0
+#define ANIMATION_NORMALIZED_MAX 65535
+
+typedef enum {
+    AnimationCurveLinear,
+    AnimationCurveEaseIn,
+    AnimationCurveEaseOut,
+    AnimationCurveEaseInOut,
+} AnimationCurve;
+
+typedef void (*AnimationSetupImplementation)(Animation *animation);
+typedef void (*AnimationUpdateImplementation)(Animation *animation, const AnimationProgress progress);
+typedef void (*AnimationTeardownImplementation)(Animation *animation);
+
+typedef struct AnimationImplementation {
+    AnimationSetupImplementation setup;
+    AnimationUpdateImplementation update;
+    AnimationTeardownImplementation teardown;
+} AnimationImplementation;
+
+Animation *animation_create(void);
+bool animation_destroy(Animation *animation);
+bool animation_set_duration(Animation *animation, uint32_t duration_ms);
+bool animation_set_curve(Animation *animation, AnimationCurve curve);
+bool animation_set_implementation(Animation *animation, const AnimationImplementation *implementation);
+bool animation_schedule(Animation *animation);
+bool animation_unschedule(Animation *animation);
+
+typedef struct UnobstructedAreaHandlers {
+    void (*will_change)(GRect final_unobstructed_screen_area, void *context);
+    void (*change)(AnimationProgress progress, void *context);
+    void (*did_change)(void *context);
+} UnobstructedAreaHandlers;
+
+void unobstructed_area_service_subscribe(UnobstructedAreaHandlers handlers, void *context);
+void unobstructed_area_service_unsubscribe(void);
+
+// Timers and services
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer_handle);
+
+typedef enum {
+    SECOND_UNIT = 1 << 0,
+    MINUTE_UNIT = 1 << 1,
+    HOUR_UNIT = 1 << 2,
+    DAY_UNIT = 1 << 3,
+    MONTH_UNIT = 1 << 4,
+    YEAR_UNIT = 1 << 5,
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+bool clock_is_24h_style(void);
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+time_t time_start_of_today(void);
+
+typedef struct {
+    uint8_t charge_percent;
+    bool is_charging;
+    bool is_plugged;
+} BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+
+BatteryChargeState battery_state_service_peek(void);
+void battery_state_service_subscribe(BatteryStateHandler handler);
+void battery_state_service_unsubscribe(void);
+
+typedef void (*BluetoothConnectionHandler)(bool connected);
+
+bool bluetooth_connection_service_peek(void);
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler);
+void bluetooth_connection_service_unsubscribe(void);
+
+typedef void (*AppFocusHandler)(bool in_focus);
+
+void app_focus_service_subscribe(AppFocusHandler handler);
+void app_focus_service_unsubscribe(void);
+
+typedef enum {
+    ACCEL_AXIS_X = 0,
+    ACCEL_AXIS_Y = 1,
+    ACCEL_AXIS_Z = 2,
+} AccelAxisType;
+
+typedef void (*AccelTapHandler)(AccelAxisType axis, int32_t direction);
+
+void accel_tap_service_subscribe(AccelTapHandler handler);
+void accel_tap_service_unsubscribe(void);
+
+typedef struct {
+    const uint32_t *durations;
+    uint32_t num_segments;
+} VibePattern;
+
+void vibes_long_pulse(void);
+void vibes_short_pulse(void);
+void vibes_enqueue_custom_pattern(VibePattern pattern);
+
+typedef int32_t HealthValue;
+
+typedef enum {
+    HealthMetricStepCount,
+    HealthMetricActiveSeconds,
+    HealthMetricWalkedDistanceMeters,
+} HealthMetric;
+
+typedef enum {
+    HealthEventSignificantUpdate,
+    HealthEventMovementUpdate,
+    HealthEventSleepUpdate,
+} HealthEventType;
+
+typedef void (*HealthEventHandler)(HealthEventType event, void *context);
+
+bool health_service_events_subscribe(HealthEventHandler handler, void *context);
+bool health_service_events_unsubscribe(void);
+HealthValue health_service_sum_today(HealthMetric metric);
+
+// Storage and resources
+
+#define PERSIST_DATA_MAX_LENGTH 256
+#define PERSIST_STRING_MAX_LENGTH PERSIST_DATA_MAX_LENGTH
+
+typedef int32_t status_t;
+
+typedef enum {
+    S_SUCCESS = 0,
+    E_ERROR = -1,
+    E_INVALID_ARGUMENT = -2,
+    E_DOES_NOT_EXIST = -10,
+} StatusCode;
+
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+bool persist_read_bool(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+int persist_read_string(const uint32_t key, char *buffer, const size_t buffer_size);
+status_t persist_write_bool(const uint32_t key, const bool value);
+status_t persist_write_int(const uint32_t key, const int32_t value);
+int persist_write_data(const uint32_t key, const void *data, const size_t size);
+int persist_write_string(const uint32_t key, const char *cstring);
+status_t persist_delete(const uint32_t key);
+
+typedef const struct ResourceFile *ResHandle;
+
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle handle);
+size_t resource_load(ResHandle handle, uint8_t *buffer, size_t max_length);
+size_t resource_load_byte_range(ResHandle handle, uint32_t start_offset, uint8_t *buffer, size_t num_bytes);
+
+size_t heap_bytes_used(void);
+size_t heap_bytes_free(void);
+
+// App messages: the harness never connects a phone, so the inbox stays
+// silent and sends succeed without reaching anyone.
+
+typedef enum {
+    APP_MSG_OK = 0,
+    APP_MSG_SEND_TIMEOUT = 1 << 1,
+    APP_MSG_SEND_REJECTED = 1 << 2,
+    APP_MSG_NOT_CONNECTED = 1 << 3,
+    APP_MSG_BUSY = 1 << 6,
+    APP_MSG_BUFFER_OVERFLOW = 1 << 7,
+    APP_MSG_OUT_OF_MEMORY = 1 << 10,
+} AppMessageResult;
+
+typedef enum {
+    DICT_OK = 0,
+    DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+    DICT_INVALID_ARGS = 1 << 2,
+} DictionaryResult;
+
+typedef enum {
+    TUPLE_BYTE_ARRAY = 0,
+    TUPLE_CSTRING = 1,
+    TUPLE_UINT = 2,
+    TUPLE_INT = 3,
+} TupleType;
+
+typedef struct __attribute__((__packed__)) {
+    uint32_t key;
+    TupleType type:8;
+    uint16_t length;
+    union {
+        uint8_t data[0];
+        char cstring[0];
+        uint8_t uint8;
+        uint16_t uint16;
+        uint32_t uint32;
+        int8_t int8;
+        int16_t int16;
+        int32_t int32;
+    } value[];
+} Tuple;
+
+typedef struct Dictionary Dictionary;
+
+typedef struct {
+    Dictionary *dictionary;
+    const void *end;
+    Tuple *cursor;
+} DictionaryIterator;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void *context);
+typedef void (*AppMessageOutboxSent)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason, void *context);
+
+#define APP_MESSAGE_INBOX_SIZE_MINIMUM 124
+#define APP_MESSAGE_OUTBOX_SIZE_MINIMUM 636
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+void app_message_deregister_callbacks(void);
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback);
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key);
+uint32_t dict_size(DictionaryIterator *iter);
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...);
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value);
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value);
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char *cstring);
+
+// Event loop: runs the scene of the harness, see pebble.c.
+void app_event_loop(void);
+
+#endif /* HEADLESS_PEBBLE_H */
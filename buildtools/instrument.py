@@ -0,0 +1,42 @@
+#
+# Opt-in instrumentation builds.
+#
+# Load it from a project wscript (in `options` and `configure`) with:
+#
+#     ctx.load('instrument', tooldir='../buildtools')
+#
+# `./waf configure --render-stats` defines RENDER_STATS for every
+# platform, which makes lib/render_stats.c log the duration, the number
+# of layer draws and the drawn pixel area of every frame, plus
+# the time from init to the first frame.
+#
+# `./waf configure --soak-stats` defines SOAK_STATS (and RENDER_STATS):
+# lib/soak_stats.c counts wakeups, redraws, peak heap, AppMessage bytes
+# and persist writes, and logs the totals every hour of watch time. See
+# buildtools/soak.py, which drives the emulator and reduces those logs.
+#
+# `./waf configure --digit-blit` defines DIGIT_FB_BLIT: lib/simplebig.c
+# copies the digit glyphs straight into the frame buffer instead of
+# drawing them through their BitmapLayers. Compare the two paths with
+# `python3 buildtools/render.py check --define DIGIT_FB_BLIT`.
+#
+
+
+def options(opt):
+    opt.add_option('--render-stats', action='store_true', default=False,
+                   help='log per-frame render timing')
+    opt.add_option('--soak-stats', action='store_true', default=False,
+                   help='log hourly wakeup, redraw, heap, message and persist totals')
+    opt.add_option('--digit-blit', action='store_true', default=False,
+                   help='blit the big digits into the frame buffer')
+
+
+def configure(ctx):
+    for platform in ctx.env.TARGET_PLATFORMS:
+        env = ctx.all_envs[platform]
+        if ctx.options.render_stats or ctx.options.soak_stats:
+            env.append_value('DEFINES', 'RENDER_STATS')
+        if ctx.options.soak_stats:
+            env.append_value('DEFINES', 'SOAK_STATS')
+        if ctx.options.digit_blit:
+            env.append_value('DEFINES', 'DIGIT_FB_BLIT')
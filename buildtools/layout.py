@@ -0,0 +1,114 @@
+#
+# Per-platform layout tables for the watchface layers.
+#
+# Load it from a project wscript (in `build`) with:
+#
+#     ctx.load('layout', tooldir='../buildtools')
+#
+# and call `ctx.pbl_layout()` before the platform loop. It compiles the
+# project's `layout.json` into `include/layout.auto.h` in the build
+# directory, which holds a `LAYOUT_*` id for every entry and one
+# `static const GRect LAYOUT_RECTS[]` table per target platform, so the
+# modules only do table lookups:
+#
+#     text_layer_create(LAYOUT_RECTS[LAYOUT_TERMO_WEATHER]);
+#
+# `layout.json` maps every id to its frames, `[x, y, w, h]`, by platform
+# name. The `default` frame is used by the platforms without their own:
+#
+#     {
+#       "TERMO_WEATHER": {"default": [32, 8, 80, 23], "chalk": [50, 16, 80, 23]}
+#     }
+#
+# Every frame must fit the screen of its platform, otherwise the build
+# fails. The header only depends on `layout.json` and the target
+# platforms, so it is only rewritten (and the sources rebuilt) when
+# one of them changes.
+#
+import json
+
+try:
+    from waflib.Configure import conf
+except ImportError:
+    # imported outside waf, by buildtools/render.py
+    def conf(function):
+        return function
+
+HEADER_NAME = 'include/layout.auto.h'
+
+SCREEN_SIZES = {
+    'aplite': (144, 168),
+    'basalt': (144, 168),
+    'chalk': (180, 180),
+    'diorite': (144, 168),
+    'emery': (200, 228),
+}
+
+
+def frame_for(name, frames, platform):
+    frame = frames.get(platform, frames.get('default'))
+    if frame is None:
+        raise ValueError('layout: no %s frame for %s' % (name, platform))
+    if len(frame) != 4:
+        raise ValueError('layout: %s frame for %s is not [x, y, w, h]' % (name, platform))
+
+    x, y, w, h = frame
+    width, height = SCREEN_SIZES[platform]
+    if x < 0 or y < 0 or x + w > width or y + h > height:
+        raise ValueError('layout: %s frame %s is off the %s screen' % (name, frame, platform))
+    return frame
+
+
+def generate_header(layout, platforms):
+    names = list(layout)
+    lines = [
+        '// Generated by buildtools/layout.py from layout.json, do not edit.',
+        '#ifndef LAYOUT_AUTO_H',
+        '#define LAYOUT_AUTO_H',
+        '',
+        'typedef enum {',
+    ]
+    lines += ['    LAYOUT_%s,' % name for name in names]
+    lines += [
+        '    LAYOUT_COUNT',
+        '} LayoutId;',
+        '',
+    ]
+
+    for i, platform in enumerate(platforms):
+        lines.append('#%s defined(PBL_PLATFORM_%s)' % ('if' if i == 0 else 'elif', platform.upper()))
+        lines.append('static const GRect LAYOUT_RECTS[LAYOUT_COUNT] __attribute__((unused)) = {')
+        for name in names:
+            lines.append('    [LAYOUT_%s] = {{%d, %d}, {%d, %d}},' % ((name,) + tuple(frame_for(name, layout[name], platform))))
+        lines.append('};')
+    lines += [
+        '#else',
+        '#error "No layout for this platform, see layout.json"',
+        '#endif',
+        '',
+        '#endif /* LAYOUT_AUTO_H */',
+        '',
+    ]
+    return '\n'.join(lines)
+
+
+def build_layout(task):
+    try:
+        layout = json.loads(task.inputs[0].read())
+        header = generate_header(layout, task.generator.platforms)
+    except ValueError as e:
+        task.generator.bld.fatal(str(e))
+    task.outputs[0].write(header)
+
+
+@conf
+def pbl_layout(ctx, spec='layout.json'):
+    header = ctx.path.get_bld().make_node(HEADER_NAME)
+    ctx(rule=build_layout,
+        source=ctx.path.find_resource(spec),
+        target=header,
+        platforms=sorted(ctx.env.TARGET_PLATFORMS),
+        vars=['TARGET_PLATFORMS'])
+
+    for platform in ctx.env.TARGET_PLATFORMS:
+        ctx.all_envs[platform].append_unique('INCLUDES', [header.parent.abspath()])
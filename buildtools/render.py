@@ -0,0 +1,357 @@
+#
+# Headless golden-image render run of the watchfaces.
+#
+# This script should be run from the root of the repository, with gcc
+# and Pillow (see fonttools/) available, like this:
+#
+#    python3 buildtools/render.py check
+#    python3 buildtools/render.py update
+#
+# Every variant is compiled for every target platform against the SDK
+# stand-in of buildtools/headless/: a software rasterizer behind the
+# pebble.h API, so the face sources build unchanged on the host. Each
+# build runs in the normal and the inverse style through a fixed scene
+# (see headless/pebble.c): the launch frame, a minute tick with its
+# animation and a battery event, and a timeline peek on rectangular
+# screens. Every step of
+# the scene is saved as a PNG, with the redraws, graphics calls ("draws")
+# and written pixels it took.
+#
+# `update` stores the frames and their counts as the goldens, in
+# `<variant>/goldens/`. `check` renders again into `--out` and compares:
+# a frame that differs from its golden by a single pixel fails, with a
+# `-diff.png` next to it in `--out` showing the changed pixels in red.
+# More draws or pixels than the golden are flagged as regressions, fewer
+# are reported so the goldens can be updated with the improvement.
+#
+# `--define` passes extra defines to the faces, to compare a build
+# option against the goldens of the default build:
+#
+#    python3 buildtools/render.py check --variants simplef-big --define SOME_OPTION
+#
+# The stand-in draws every system font with one bitmap font, so text
+# shows where it is placed, not how the watch renders it. Draw and pixel
+# counts are those of the stand-in, not timings: they compare builds
+# with each other, not with the watch.
+#
+import argparse
+import json
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+
+from PIL import Image
+
+import layout
+
+VARIANTS = ["simplef", "simplef-big", "simplef-termo"]
+STYLES = ["normal", "inverse"]
+
+HEADLESS_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "headless")
+
+PLATFORMS = {
+    "aplite": {"color": False, "round": False, "health": False},
+    "basalt": {"color": True, "round": False, "health": True},
+    "chalk": {"color": True, "round": True, "health": True},
+    "diorite": {"color": False, "round": False, "health": True},
+    "emery": {"color": True, "round": False, "health": True},
+}
+
+# GBitmapFormat values, see headless/pebble.h
+BITMAP_FORMATS = {"1Bit": 0, "8Bit": 1, "1BitPalette": 2}
+
+# message keys are numbered from here, like the SDK does
+FIRST_MESSAGE_KEY = 10000
+
+FRAME_LINE = re.compile(r"frame (\w+): (\d+) redraws, (\d+) draws, (\d+) px")
+FRAME_FIELDS = ["redraws", "draws", "px"]
+
+
+def platform_tags(platform):
+    info = PLATFORMS[platform]
+    return {platform, "color" if info["color"] else "bw", "round" if info["round"] else "rect"}
+
+
+def resource_file(variant, name, platform):
+    """The tagged variant of a resource file for a platform, like the SDK picks it."""
+    resources = os.path.join(variant, "resources")
+    directory, base = os.path.split(name)
+    stem, ext = os.path.splitext(base)
+    tags = platform_tags(platform)
+
+    best, best_tags = None, None
+    for candidate in os.listdir(os.path.join(resources, directory)):
+        candidate_stem, candidate_ext = os.path.splitext(candidate)
+        parts = candidate_stem.split("~")
+        if parts[0] != stem or candidate_ext != ext or not set(parts[1:]) <= tags:
+            continue
+        # the platform tag wins, then the most specific file
+        rank = (platform in parts[1:], len(parts) - 1)
+        if best is None or rank > best_tags:
+            best, best_tags = candidate, rank
+    if best is None:
+        raise ValueError("render: no %s for %s" % (name, platform))
+    return os.path.join(resources, directory, best)
+
+
+def quantize(rgba):
+    r, g, b, a = rgba
+    return (round(a / 85) << 6) | (round(r / 85) << 4) | (round(g / 85) << 2) | round(b / 85)
+
+
+def convert_bitmap(path, memory_format):
+    """A PNG as the stand-in loads it: header, palette, then the rows."""
+    image = Image.open(path).convert("RGBA")
+    width, height = image.size
+    pixels = [quantize(image.getpixel((x, y))) for y in range(height) for x in range(width)]
+
+    palette = []
+    if memory_format == "1Bit":
+        row_size = (width + 31) // 32 * 4
+        # white pixels set, leftmost pixel in the lowest bit
+        values = [1 if ((p >> 4) & 3) + ((p >> 2) & 3) + (p & 3) >= 5 else 0 for p in pixels]
+    elif memory_format == "1BitPalette":
+        row_size = (width + 7) // 8
+        for p in pixels:
+            if p not in palette:
+                palette.append(p)
+        if len(palette) > 2:
+            raise ValueError("render: %s has more than two colors" % path)
+        palette += [0] * (2 - len(palette))
+        values = [palette.index(p) for p in pixels]
+    elif memory_format == "8Bit":
+        row_size = width
+        values = pixels
+    else:
+        raise ValueError("render: %s memory format of %s is not supported" % (memory_format, path))
+
+    rows = bytearray(row_size * height)
+    for y in range(height):
+        for x in range(width):
+            value = values[y * width + x]
+            if memory_format == "1Bit":
+                rows[y * row_size + x // 8] |= value << (x % 8)
+            elif memory_format == "1BitPalette":
+                rows[y * row_size + x // 8] |= value << (7 - x % 8)
+            else:
+                rows[y * row_size + x] = value
+
+    header = struct.pack("<BBHHH", BITMAP_FORMATS[memory_format], len(palette), width, height, row_size)
+    return header + bytes(palette) + bytes(rows)
+
+
+def write_resources(variant, package, platform, work):
+    """Writes the resources of a platform and returns the resource ids header."""
+    resources_dir = os.path.join(work, "resources")
+    os.makedirs(resources_dir, exist_ok=True)
+
+    ids = {}
+    for media in package["resources"]["media"]:
+        if platform not in media.get("targetPlatforms", [platform]) or media["name"] in ids:
+            continue
+        ids[media["name"]] = len(ids) + 1
+        path = resource_file(variant, media["file"], platform)
+
+        if media["type"] == "raw":
+            with open(path, "rb") as raw_file:
+                data = raw_file.read()
+        else:
+            memory_format = media.get("memoryFormat", "1Bit")
+            if media["type"] == "pbi":
+                memory_format = "1Bit"
+            data = convert_bitmap(path, memory_format)
+        with open(os.path.join(resources_dir, "%d.bin" % ids[media["name"]]), "wb") as bin_file:
+            bin_file.write(data)
+
+    lines = ["// Generated by buildtools/render.py, do not edit.", "enum {"]
+    lines += ["    RESOURCE_ID_%s = %d," % (name, number) for name, number in ids.items()]
+    lines += ["};", ""]
+    return "\n".join(lines)
+
+
+def message_keys_header(package):
+    lines = ["// Generated by buildtools/render.py, do not edit.", "enum {"]
+    lines += ["    MESSAGE_KEY_%s = %d," % (name, FIRST_MESSAGE_KEY + i)
+              for i, name in enumerate(package.get("messageKeys", []))]
+    lines += ["};", ""]
+    return "\n".join(lines)
+
+
+def platform_defines(platform):
+    info = PLATFORMS[platform]
+    defines = ["PBL_PLATFORM_" + platform.upper(), "PBL_SDK_3",
+               "PBL_COLOR" if info["color"] else "PBL_BW",
+               "PBL_ROUND" if info["round"] else "PBL_RECT"]
+    if info["health"]:
+        defines.append("PBL_HEALTH")
+    return defines
+
+
+def build_face(variant, package, platform, work, defines):
+    os.makedirs(work, exist_ok=True)
+    with open(os.path.join(variant, "layout.json")) as layout_file:
+        header = layout.generate_header(json.load(layout_file), [platform])
+    headers = {
+        "layout.auto.h": header,
+        "resource_ids.auto.h": write_resources(variant, package, platform, work),
+        "message_keys.auto.h": message_keys_header(package),
+    }
+    for name, text in headers.items():
+        with open(os.path.join(work, name), "w") as header_file:
+            header_file.write(text)
+
+    src = os.path.join(variant, "src")
+    sources = sorted(os.path.join(src, name) for name in os.listdir(src) if name.endswith(".c"))
+    binary = os.path.join(work, "face")
+    command = (["gcc", "-std=c99", "-D_DEFAULT_SOURCE", "-O1",
+                "-I", HEADLESS_DIR, "-I", work, "-I", src]
+               + ["-D" + define for define in platform_defines(platform) + defines]
+               + sources + [os.path.join(HEADLESS_DIR, "pebble.c"), "-o", binary, "-lm"])
+    subprocess.check_call(command)
+    return binary
+
+
+def run_face(binary, work, style, out_dir, prefix):
+    """Plays the scene and returns the counts of every frame, by image name."""
+    frames_dir = os.path.join(work, style)
+    os.makedirs(frames_dir, exist_ok=True)
+    env = dict(os.environ, HEADLESS_OUT=frames_dir, HEADLESS_STYLE=style,
+               HEADLESS_RESOURCES=os.path.join(work, "resources"))
+    result = subprocess.run([binary], env=env, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                            universal_newlines=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stderr)
+        raise RuntimeError("render: %s exited with %d" % (binary, result.returncode))
+
+    stats = {}
+    for match in FRAME_LINE.finditer(result.stdout):
+        name = "%s-%s-%s" % (prefix, style, match.group(1))
+        stats[name] = dict(zip(FRAME_FIELDS, map(int, match.groups()[1:])))
+        Image.open(os.path.join(frames_dir, match.group(1) + ".ppm")).save(os.path.join(out_dir, name + ".png"))
+    return stats
+
+
+def render_variant(variant, options):
+    with open(os.path.join(variant, "package.json")) as package_file:
+        package = json.load(package_file)["pebble"]
+
+    out_dir = os.path.join(options.out, variant)
+    shutil.rmtree(out_dir, ignore_errors=True)
+    os.makedirs(out_dir)
+
+    stats = {}
+    for platform in package["targetPlatforms"]:
+        if options.platforms and platform not in options.platforms:
+            continue
+        work = os.path.join(out_dir, "build", platform)
+        binary = build_face(variant, package, platform, work, options.define)
+        for style in STYLES:
+            stats.update(run_face(binary, work, style, out_dir, platform))
+    return out_dir, stats
+
+
+def diff_pixels(path, golden_path, diff_path):
+    image = Image.open(path).convert("RGB")
+    golden = Image.open(golden_path).convert("RGB")
+    if image.size != golden.size:
+        return image.size[0] * image.size[1]
+
+    changed = 0
+    diff = golden.convert("L").convert("RGB")
+    for y in range(image.size[1]):
+        for x in range(image.size[0]):
+            if image.getpixel((x, y)) != golden.getpixel((x, y)):
+                changed += 1
+                diff.putpixel((x, y), (255, 0, 0))
+    if changed:
+        diff.save(diff_path)
+    return changed
+
+
+def update(options):
+    for variant in options.variants:
+        out_dir, stats = render_variant(variant, options)
+        goldens_dir = os.path.join(variant, "goldens")
+        if not options.platforms:
+            shutil.rmtree(goldens_dir, ignore_errors=True)
+        os.makedirs(goldens_dir, exist_ok=True)
+
+        stats_path = os.path.join(goldens_dir, "stats.json")
+        golden_stats = {}
+        if options.platforms and os.path.exists(stats_path):
+            with open(stats_path) as stats_file:
+                golden_stats = json.load(stats_file)
+        golden_stats.update(stats)
+
+        for name in stats:
+            shutil.copy(os.path.join(out_dir, name + ".png"), os.path.join(goldens_dir, name + ".png"))
+        with open(stats_path, "w") as stats_file:
+            json.dump(golden_stats, stats_file, indent=2, sort_keys=True)
+            stats_file.write("\n")
+        print("%s: %d goldens updated" % (variant, len(stats)))
+    return 0
+
+
+def check(options):
+    header = ("frame", "pixels", "redraws", "draws", "px")
+    rows = []
+    failed = False
+    for variant in options.variants:
+        out_dir, stats = render_variant(variant, options)
+        goldens_dir = os.path.join(variant, "goldens")
+        golden_stats = {}
+        stats_path = os.path.join(goldens_dir, "stats.json")
+        if os.path.exists(stats_path):
+            with open(stats_path) as stats_file:
+                golden_stats = json.load(stats_file)
+
+        for name in sorted(stats):
+            golden_path = os.path.join(goldens_dir, name + ".png")
+            if not os.path.exists(golden_path) or name not in golden_stats:
+                rows.append(("%s/%s" % (variant, name), "NO GOLDEN", "-", "-", "-"))
+                failed = True
+                continue
+
+            changed = diff_pixels(os.path.join(out_dir, name + ".png"), golden_path,
+                                  os.path.join(out_dir, name + "-diff.png"))
+            cells = ["%d DIFF" % changed if changed else "same"]
+            failed = failed or changed > 0
+            for field in FRAME_FIELDS:
+                value, golden = stats[name][field], golden_stats[name][field]
+                if value > golden:
+                    cells.append("%d (%+d) MORE" % (value, value - golden))
+                    failed = True
+                elif value < golden:
+                    cells.append("%d (%+d)" % (value, value - golden))
+                else:
+                    cells.append(str(value))
+            rows.append(("%s/%s" % (variant, name),) + tuple(cells))
+
+    widths = [max(len(row[i]) for row in [header] + rows) for i in range(len(header))]
+    for row in [header] + rows:
+        print("  ".join(cell.ljust(width) for cell, width in zip(row, widths)).rstrip())
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Headless golden-image render run of the watchfaces")
+    commands = parser.add_subparsers(dest="command")
+    for name, help_text in (("check", "render every face and compare with the goldens"),
+                            ("update", "render every face and store the goldens")):
+        command_parser = commands.add_parser(name, help=help_text)
+        command_parser.add_argument("--variants", nargs="+", default=VARIANTS, choices=VARIANTS)
+        command_parser.add_argument("--platforms", nargs="+", help="only these platforms")
+        command_parser.add_argument("--define", action="append", default=[],
+                                    help="extra define for the faces, can be repeated")
+        command_parser.add_argument("--out", default="render", help="frame directory")
+
+    options = parser.parse_args()
+    if options.command == "check":
+        sys.exit(check(options))
+    elif options.command == "update":
+        sys.exit(update(options))
+    else:
+        parser.print_help()
@@ -0,0 +1,262 @@
+#
+# 24 hour soak run of the watchfaces on the Pebble emulator.
+#
+# This script should be run from the root of the repository, with the
+# Pebble tool on the PATH and its libpebble2 importable (use the Python
+# of the tool's environment, or `pip install libpebble2`), like this:
+#
+#    python3 buildtools/soak.py run
+#    python3 buildtools/soak.py report soak/*.log
+#
+# `run` builds every variant with `--soak-stats` (see instrument.py),
+# then installs it on the emulator of every target platform in turn and
+# moves the emulator clock through a day in `--step` minute jumps. The
+# Pebble tool has no command for the clock, so it is set like a phone
+# does, with a Pebble Protocol time message sent through the emulator's
+# pypkjs websocket, and read back to check it took. Along
+# the way it drains and charges the battery, drops and restores the
+# Bluetooth connection, shows and hides the timeline peek and flicks the
+# wrist, on the fixed schedule of `events()`. The app logs of every run
+# are kept in `--out` and reduced into the report at the end.
+#
+# The phone side of simplef-termo talks to a local stand-in server (see
+# standin.py): the emulator is started with it as HTTP proxy, so
+# termopogoda requests get a canned temperature and HTTPS lookups
+# (geocoding, conditions, open-meteo) are refused right away, like on a
+# phone without network.
+#
+# To compare the weather modes of simplef-termo, soak it once per mode
+# with the "Phone pushes the weather" setting toggled in between (the
+# settings survive reinstalls) and `--label` set, then report both:
+#
+#    python3 buildtools/soak.py run --variants simplef-termo --label pull
+#    python3 buildtools/soak.py run --variants simplef-termo --label push
+#    python3 buildtools/soak.py report soak/simplef-termo-*.log
+#
+# Pull mode sends one request every quarter of an hour of emulator time.
+# The phone timer of push mode runs on real time, so over a soak the
+# pushed weather goes stale in emulator time and the watch falls back to
+# a request about every 45 minutes: the "msg out" and "wakeups" columns
+# show that fallback, not a phone that keeps pushing.
+#
+# This comparison has not been run yet. No wakeup, message or battery
+# numbers exist for either mode, on the emulator or on a watch, so push
+# mode stays off by default (PUSH_MODE in lib/termo-clay.js).
+#
+# `report` reduces the `soak:` lines logged by lib/soak_stats.c into one
+# row per face: wakeups, redraws, peak heap, heap growth between the
+# first and the last hourly line, AppMessage bytes and persist writes.
+# Growing heap is flagged, as it usually means a leaked bitmap.
+#
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+from standin import start_stand_in
+
+VARIANTS = ["simplef", "simplef-big", "simplef-termo"]
+
+# 2024-03-01 00:00 UTC, any fixed day works
+START_TIME = 1709251200
+
+SOAK_LINE = re.compile(r"soak: wakeups (\d+) redraws (\d+) heap (\d+) peak (\d+) "
+                       r"in (\d+) out (\d+) persist (\d+) (\d+)")
+SOAK_FIELDS = ["wakeups", "redraws", "heap", "peak", "in", "out", "persist", "persist_bytes"]
+
+# Heap growth over the day tolerated before a face is flagged, in bytes.
+HEAP_GROWTH_LIMIT = 256
+
+
+def events(minute):
+    """Emulator commands for one simulated minute of the day."""
+    hour, minute_of_hour = divmod(minute, 60)
+    commands = []
+
+    # drain 4% an hour, charge from 18:00 to 22:00
+    if minute_of_hour == 0:
+        if 18 <= hour < 22:
+            commands.append(["emu-battery", "--percent", str(min(100, 28 + (hour - 18) * 20)), "--charging"])
+        else:
+            percent = 100 - 4 * hour if hour < 18 else 100 - 4 * (hour - 22)
+            commands.append(["emu-battery", "--percent", str(max(percent, 0))])
+
+    # two Bluetooth drops of a quarter of an hour
+    if hour in (3, 11) and minute_of_hour == 0:
+        commands.append(["emu-bt-connection", "--connected", "no"])
+    if hour in (3, 11) and minute_of_hour == 15:
+        commands.append(["emu-bt-connection", "--connected", "yes"])
+
+    # timeline peek at 6:00 and 14:00 for half an hour
+    if hour in (6, 14) and minute_of_hour == 0:
+        commands.append(["emu-set-timeline-quick-view", "on"])
+    if hour in (6, 14) and minute_of_hour == 30:
+        commands.append(["emu-set-timeline-quick-view", "off"])
+
+    # a wrist flick every two hours
+    if hour % 2 == 0 and minute_of_hour == 45:
+        commands.append(["emu-tap", "--direction", "x+"])
+
+    return commands
+
+
+def pebble(args, cwd, env, platform=None):
+    command = ["pebble"] + args
+    if platform:
+        command += ["--emulator", platform]
+    subprocess.check_call(command, cwd=cwd, env=env, stdout=subprocess.DEVNULL)
+
+
+class EmulatorClock(object):
+    """Sets the clock of a running emulator over the Pebble Protocol."""
+
+    def __init__(self, platform):
+        try:
+            from libpebble2.communication import PebbleConnection
+            from libpebble2.communication.transports.websocket import WebsocketTransport
+        except ImportError:
+            sys.exit("soak: libpebble2 is needed to set the emulator clock")
+
+        # written by the Pebble tool when it starts an emulator
+        with open(os.path.join(tempfile.gettempdir(), "pb-emulator.json")) as info_file:
+            versions = json.load(info_file).get(platform, {})
+        if not versions:
+            sys.exit("soak: no %s emulator running" % platform)
+        port = list(versions.values())[0]["pypkjs"]["port"]
+
+        self.connection = PebbleConnection(WebsocketTransport("ws://localhost:%d/" % port))
+        self.connection.connect()
+        self.connection.run_async()
+
+    def set(self, timestamp):
+        from libpebble2.protocol.system import GetTimeRequest, SetUTC, TimeMessage
+
+        self.connection.send_packet(TimeMessage(message=SetUTC(unix_time=timestamp, utc_offset=0, tz_name="UTC")))
+        response = self.connection.send_and_read(TimeMessage(message=GetTimeRequest()), TimeMessage)
+        if abs(response.message.time - timestamp) > 60:
+            sys.exit("soak: emulator clock is %d, expected %d" % (response.message.time, timestamp))
+
+    def close(self):
+        self.connection.transport.ws.close()
+
+
+def soak_face(variant, platform, options, env, clock):
+    label = "-" + options.label if options.label else ""
+    log_path = os.path.join(options.out, "%s-%s%s.log" % (variant, platform, label))
+    print("soaking %s on %s" % (variant, platform))
+
+    # installing boots the emulator, the clock is set right after
+    pebble(["install"], variant, env, platform)
+    emulator_clock = EmulatorClock(platform)
+    emulator_clock.set(START_TIME)
+    with open(log_path, "w") as log_file:
+        logs = subprocess.Popen(["pebble", "logs", "--emulator", platform],
+                                cwd=variant, env=env, stdout=log_file, stderr=subprocess.STDOUT)
+        try:
+            for minute in range(0, options.hours * 60 + 1, options.step):
+                clock.now = START_TIME + minute * 60
+                emulator_clock.set(clock.now)
+                # the events of the whole step happen at its start
+                for skipped in range(minute, min(minute + options.step, options.hours * 60 + 1)):
+                    for command in events(skipped % (24 * 60)):
+                        pebble(command, variant, env, platform)
+                time.sleep(options.delay)
+        finally:
+            emulator_clock.close()
+            # the last hourly line has the day totals
+            pebble(["kill"], variant, env)
+            logs.terminate()
+            logs.wait()
+    return log_path
+
+
+def run(options):
+    class Clock(object):
+        now = START_TIME
+
+    clock = Clock()
+    server = start_stand_in(lambda: clock.now)
+    proxy = "http://127.0.0.1:%d" % server.server_address[1]
+
+    env = dict(os.environ)
+    env.update({"http_proxy": proxy, "https_proxy": proxy, "HTTP_PROXY": proxy, "HTTPS_PROXY": proxy})
+
+    os.makedirs(options.out, exist_ok=True)
+    log_paths = []
+    for variant in options.variants:
+        subprocess.check_call(["pebble", "build", "--", "--soak-stats"], cwd=variant, env=env)
+        with open(os.path.join(variant, "package.json")) as package_file:
+            platforms = json.load(package_file)["pebble"]["targetPlatforms"]
+        for platform in platforms:
+            if options.platforms and platform not in options.platforms:
+                continue
+            log_paths.append(soak_face(variant, platform, options, env, clock))
+
+    server.shutdown()
+    return report(log_paths)
+
+
+def reduce_log(path):
+    lines = []
+    with open(path, errors="replace") as log_file:
+        for line in log_file:
+            match = SOAK_LINE.search(line)
+            if match:
+                lines.append(dict(zip(SOAK_FIELDS, map(int, match.groups()))))
+    return lines
+
+
+def report(log_paths):
+    header = ("face", "wakeups", "redraws", "peak heap", "heap growth", "msg in", "msg out", "persist")
+    rows = []
+    flagged = False
+    for path in sorted(log_paths):
+        face = os.path.splitext(os.path.basename(path))[0]
+        lines = reduce_log(path)
+        if not lines:
+            print("%s: no soak lines, built without --soak-stats?" % path, file=sys.stderr)
+            rows.append((face,) + ("-",) * 7)
+            flagged = True
+            continue
+
+        first, last = lines[0], lines[-1]
+        growth = last["heap"] - first["heap"]
+        flag = " LEAK?" if growth > HEAP_GROWTH_LIMIT else ""
+        flagged = flagged or bool(flag)
+        rows.append((face, str(last["wakeups"]), str(last["redraws"]), str(last["peak"]),
+                     "%+d%s" % (growth, flag), str(last["in"]), str(last["out"]),
+                     "%d (%d B)" % (last["persist"], last["persist_bytes"])))
+
+    widths = [max(len(row[i]) for row in [header] + rows) for i in range(len(header))]
+    for row in [header] + rows:
+        print("  ".join(cell.ljust(width) for cell, width in zip(row, widths)).rstrip())
+    return 1 if flagged else 0
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Emulator soak run of the watchfaces")
+    commands = parser.add_subparsers(dest="command")
+
+    run_parser = commands.add_parser("run", help="soak every face and report")
+    run_parser.add_argument("--variants", nargs="+", default=VARIANTS, choices=VARIANTS)
+    run_parser.add_argument("--platforms", nargs="+", help="only these platforms")
+    run_parser.add_argument("--hours", type=int, default=24)
+    run_parser.add_argument("--step", type=int, default=5, help="simulated minutes per clock jump")
+    run_parser.add_argument("--delay", type=float, default=0.5, help="seconds between clock jumps")
+    run_parser.add_argument("--out", default="soak", help="log directory")
+    run_parser.add_argument("--label", help="suffix of the log names, to tell runs apart")
+
+    report_parser = commands.add_parser("report", help="reduce soak logs")
+    report_parser.add_argument("logs", nargs="+")
+
+    options = parser.parse_args()
+    if options.command == "run":
+        sys.exit(run(options))
+    elif options.command == "report":
+        sys.exit(report(options.logs))
+    else:
+        parser.print_help()
@@ -0,0 +1,123 @@
+#
+# Local stand-in for the weather providers of simplef-termo (see
+# lib/weather.js), with configurable delays and failures.
+#
+# This script should be run from the root of the repository, like this:
+#
+#    python3 buildtools/standin.py --delay termopogoda=3 --fail open-meteo=0.5
+#
+# It answers the termopogoda and open-meteo requests with a temperature
+# that follows the hour of the day, after the `--delay` of the provider
+# in seconds. A provider with `--fail` answers that share of its
+# requests with an error, `--fail NAME=hang` never answers at all (for
+# the deadline), `--fail NAME=garbage` answers with an invalid body.
+#
+# Point the phone at it by storing the printed JSON under the
+# `termo-provider-urls` localStorage key, from the PebbleKit JS console:
+#
+#    localStorage.setItem("termo-provider-urls", '{"termopogoda": ...}')
+#
+# Requests through an HTTP proxy carry the full URL, so it also works as
+# the emulator proxy (soak.py runs it that way). HTTPS is refused then.
+#
+import argparse
+import json
+import random
+import threading
+import time
+
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+PROVIDER_PATHS = {
+    "termopogoda": "/data.json",
+    "open-meteo": "/v1/forecast",
+}
+
+
+def temperature(now):
+    return time.gmtime(now).tm_hour - 12 + 0.5
+
+
+def provider_body(provider, now):
+    if provider == "termopogoda":
+        return {"current_temp": "%.1f" % temperature(now)}
+    # overcast
+    return {"current": {"temperature_2m": temperature(now), "weather_code": 3}}
+
+
+class StandInHandler(BaseHTTPRequestHandler):
+    """Answers the provider requests, after the configured delays."""
+
+    def provider(self):
+        for provider, path in PROVIDER_PATHS.items():
+            if path in self.path:
+                return provider
+        return None
+
+    def do_GET(self):
+        provider = self.provider()
+        if provider is None:
+            self.send_error(404)
+            return
+
+        time.sleep(self.server.delays.get(provider, 0))
+        failure = self.server.failures.get(provider)
+        if failure == "hang":
+            time.sleep(3600)
+            return
+        if failure not in (None, "garbage") and random.random() < float(failure):
+            self.send_error(503)
+            return
+
+        if failure == "garbage":
+            body = b"<html>maintenance</html>"
+        else:
+            body = json.dumps(provider_body(provider, self.server.clock())).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_CONNECT(self):
+        self.send_error(502)
+
+    def log_message(self, format, *args):
+        pass
+
+
+def start_stand_in(clock=time.time, delays=None, failures=None, port=0):
+    server = ThreadingHTTPServer(("127.0.0.1", port), StandInHandler)
+    server.daemon_threads = True
+    server.clock = clock
+    server.delays = delays or {}
+    server.failures = failures or {}
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return server
+
+
+def provider_option(value):
+    provider, _, setting = value.partition("=")
+    if provider not in PROVIDER_PATHS or not setting:
+        raise argparse.ArgumentTypeError("expected NAME=VALUE with NAME in %s" % ", ".join(sorted(PROVIDER_PATHS)))
+    return provider, setting
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Stand-in weather providers")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--delay", type=provider_option, action="append", default=[],
+                        help="NAME=SECONDS before answering")
+    parser.add_argument("--fail", type=provider_option, action="append", default=[],
+                        help="NAME=SHARE of errors, NAME=hang or NAME=garbage")
+    options = parser.parse_args()
+
+    delays = dict((provider, float(seconds)) for provider, seconds in options.delay)
+    server = start_stand_in(delays=delays, failures=dict(options.fail), port=options.port)
+    base_url = "http://127.0.0.1:%d" % server.server_address[1]
+    print(json.dumps(dict((provider, base_url) for provider in sorted(PROVIDER_PATHS))))
+    try:
+        while True:
+            time.sleep(3600)
+    except KeyboardInterrupt:
+        server.shutdown()
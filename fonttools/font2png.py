@@ -1,104 +1,165 @@
 #
-# Used to create image tiles suitable for use by the "Big Watch" watch
-# face.
+# Used to create the digit image tiles for the "big" watch faces
+# (simplef-big and simplef-termo) for every platform in one pass.
 #
-# The meta data for the images produced is output to the terminal for
-# copy pasta into `resource_map.json`.
+# This script should be run from the root of the repository, like this:
 #
+#    python3 fonttools/font2png.py
 #
-# This script should be run from the root of the watch project
-# directory, like this:
+# It renders `resources/fonts/watchfont.ttf` into one tile per digit for
+# each entry of `PLATFORM_TILES`, writes them to `resources/images/` with
+# the platform tag the SDK expects (`num_0.png`, `num_0~emery.png`, ...)
+# and replaces the `IMAGE_NUM_0` to `IMAGE_NUM_9` media entries of every
+# project listed in `PROJECTS` in place, so there is nothing to paste by
+# hand and the rest of each package.json is left as it was.
 #
-#    python fonttools/font2png.py
+# The tiles are thresholded here and saved as 1-bit PNGs, so they are
+# stored and loaded as packed 1-bit bitmaps on every platform and no
+# anti-aliasing grey is left for the resource compiler to dither. Color
+# platforms get the 1-bit palettized format, so the faces can theme the
+# glyphs by swapping their palette. Output only depends on the font and
+# the tables below, so re-running the script on unchanged inputs gives
+# byte-identical files.
 #
-# On Mac OS X you can use it like this to have the meta data copied
-# directly to the clipboard, ready for pasting:
+# Use `--metadata-only` to rewrite the package.json entries without
+# rendering (useful when Pillow isn't installed).
 #
-#     python fonttools/font2png.py | pbcopy
-#
-#
-# These image tiles are needed because Pebble can't handle the 100
-# point font size required by the watch. Each image tile is a quarter
-# of the display.
-#
-# The generation of tiles is more complicated than it needs to be due to:
-#
-#   a) For Nevis (at least) the digits seem to return a fixed height
-#      of 115 pixels even though the digits don't take up that much
-#      vertical space. This means we can't use `getsize()` for
-#      dimensions.
-#
-#   b) The bottom of the digits seem to get clipped (by PIL) unless
-#      the canvas has a bunch of extra space. (This may be related to
-#      <http://stackoverflow.com/questions/1933766/fonts-clipping-with-pil>
-#      or
-#      <http://stackoverflow.com/questions/13821882/pil-cut-off-letters/13831117#13831117>.)
-#
-# Because of these complications, we have to center the digit
-# manually.
-#
-# We first plot the digit on a large canvas, then crop to just the
-# bounds of the character and then paste the result centered on a
-# canvas of the correct size.
+# Each tile is a quarter of the display. We can't use `getsize()` for
+# the digit dimensions (some fonts report a fixed line height) and PIL
+# clips the bottom of glyphs drawn without spare room, so every digit is
+# drawn on a large scratch canvas, cropped to its bounding box and then
+# pasted centered on a canvas of the tile size.
 #
 
-import ImageFont, ImageDraw, Image, ImageOps
+import json
+import sys
 
-FONT_SIZE = 100
 FONT_FILE_PATH = "resources/fonts/watchfont.ttf"
-
-OUTPUT_IMAGE_FILEPATH_TEMPLATE = "resources/images/num_%d.png"
-
-
-TILE_WIDTH_PIXELS = 34
-TILE_HEIGHT_PIXELS = 168/2
-
-LARGE_SCRATCH_CANVAS_DIMENSIONS = (100, 100)
-FINAL_TILE_CANVAS_DIMENSIONS = (TILE_WIDTH_PIXELS, TILE_HEIGHT_PIXELS)
-
-META_DATA_TEMPLATE = \
-"""
-        {
-            "type": "png",
-            "name": "IMAGE_NUM_%d",
-            "file": "images/num_%d.png"
-        }"""
-
-
-meta_data_entries = []
-
-font = ImageFont.truetype(FONT_FILE_PATH, FONT_SIZE)
+OUTPUT_IMAGE_FILEPATH_TEMPLATE = "resources/images/num_%d%s.png"
+RESOURCE_FILE_TEMPLATE = "images/num_%d.png"
+RESOURCE_NAME_TEMPLATE = "IMAGE_NUM_%d"
+
+PROJECTS = ["simplef-big", "simplef-termo"]
+BW_PLATFORMS = ["aplite", "diorite"]
+
+# Platform tag -> (tile width, tile height, font size, threshold).
+# The untagged entry is used by aplite, basalt, chalk and diorite. Sizes
+# and thresholds keep the glyph metrics and stroke weight of the
+# anti-aliased tiles these replaced.
+PLATFORM_TILES = {
+    "": (34, 168 // 2, 100, 96),
+    "emery": (48, 114, 140, 128),
+}
+
+
+def render_tile(font, digit, width, height, threshold):
+    from PIL import Image, ImageDraw
+
+    # Draw the digit on a large canvas so PIL doesn't crop it.
+    scratch_size = (font.size * 2, font.size * 2)
+    scratch_canvas_image = Image.new("L", scratch_size, 0)
+    ImageDraw.Draw(scratch_canvas_image).text((0, 0), str(digit), font=font, fill=255)
+
+    # Discard all the padding
+    cropped_digit_image = scratch_canvas_image.crop(scratch_canvas_image.getbbox())
+    digit_width, digit_height = cropped_digit_image.size
+
+    # Center the digit within the final tile: black digit on white.
+    tile_image = Image.new("L", (width, height), 0)
+    tile_image.paste(cropped_digit_image, ((width - digit_width) // 2, (height - digit_height) // 2))
+    return tile_image.point(lambda value: 0 if value >= threshold else 255, "1")
+
+
+def render_tiles():
+    from PIL import ImageFont
+
+    for tag, (width, height, font_size, threshold) in sorted(PLATFORM_TILES.items()):
+        font = ImageFont.truetype(FONT_FILE_PATH, font_size)
+        suffix = "~" + tag if tag else ""
+        for digit in range(0, 10):
+            tile_image = render_tile(font, digit, width, height, threshold)
+            tile_image.save(OUTPUT_IMAGE_FILEPATH_TEMPLATE % (digit, suffix), optimize=True)
+
+
+def media_entries(platforms):
+    # The SDK picks the `~emery` file by itself, so entries only differ
+    # by memory format.
+    formats = [
+        ("1Bit", [platform for platform in platforms if platform in BW_PLATFORMS]),
+        ("1BitPalette", [platform for platform in platforms if platform not in BW_PLATFORMS]),
+    ]
+    return [{
+        "file": RESOURCE_FILE_TEMPLATE % digit,
+        "name": RESOURCE_NAME_TEMPLATE % digit,
+        "type": "bitmap",
+        "memoryFormat": memory_format,
+        "targetPlatforms": target_platforms,
+    } for digit in range(9, -1, -1) for memory_format, target_platforms in formats if target_platforms]
+
+
+def media_spans(text):
+    """Returns the (start, end) of every entry of the media list."""
+    decoder = json.JSONDecoder()
+    spans = []
+    position = text.index("[", text.index('"media"')) + 1
+    while True:
+        position = len(text) - len(text[position:].lstrip(" \t\r\n,"))
+        if text[position] == "]":
+            return spans
+        end = decoder.raw_decode(text, position)[1]
+        spans.append((position, end))
+        position = end
+
+
+def format_entry(entry, indent, inline_lists):
+    fields = []
+    for key, value in entry.items():
+        if inline_lists and isinstance(value, list):
+            value = "[" + ", ".join(json.dumps(item) for item in value) + "]"
+        else:
+            value = json.dumps(value, indent=2).replace("\n", "\n  ")
+        fields.append("  %s: %s" % (json.dumps(key), value))
+    return ("{\n" + ",\n".join(fields) + "\n}").replace("\n", "\n" + indent)
+
+
+def update_package(project):
+    path = project + "/package.json"
+    with open(path) as package_file:
+        text = package_file.read()
+
+    names = set(RESOURCE_NAME_TEMPLATE % digit for digit in range(0, 10))
+    package = json.loads(text)
+    media = package["pebble"]["resources"]["media"]
+    spans = media_spans(text)
+    digits = [i for i, entry in enumerate(media) if entry["name"] in names]
+    kept = [span for entry, span in zip(media, spans) if entry["name"] not in names]
+
+    # New entries follow the layout of the platform lists already there
+    kept_text = "".join(text[start:end] for start, end in kept)
+    inline_lists = '"targetPlatforms": [\n' not in kept_text
+    line_start = text.rindex("\n", 0, spans[0][0]) + 1
+    indent = text[line_start:spans[0][0]]
+    generated = [format_entry(entry, indent, inline_lists)
+                 for entry in media_entries(package["pebble"]["targetPlatforms"])]
+
+    # Only the digit entries are replaced, everything else is kept as
+    # written
+    if digits:
+        if digits != list(range(digits[0], digits[-1] + 1)):
+            sys.exit("%s: the IMAGE_NUM_* entries are not together" % path)
+        first, last = spans[digits[0]][0], spans[digits[-1]][1]
+        text = text[:first] + (",\n" + indent).join(generated) + text[last:]
+    else:
+        end = spans[-1][1]
+        text = text[:end] + ",\n" + indent + (",\n" + indent).join(generated) + text[end:]
+
+    with open(path, "w") as package_file:
+        package_file.write(text)
 
 
 if __name__ == "__main__":
-    # Generate the image tile file for each digit.
-    for digit in range(0, 10):
-        # Draw the digit on a large canvas so PIL doesn't crop it.
-        scratch_canvas_image = Image.new("RGB", LARGE_SCRATCH_CANVAS_DIMENSIONS)
-        draw = ImageDraw.Draw(scratch_canvas_image)
-
-        draw.text((0,0), str(digit), font=font)
-
-        # Discard all the padding
-        cropped_digit_image = scratch_canvas_image.crop(scratch_canvas_image.getbbox())
-
-        # Center the digit within the final image tile and save it
-        digit_width, digit_height = cropped_digit_image.size
-
-        tile_image = Image.new("RGB", FINAL_TILE_CANVAS_DIMENSIONS)
-
-        tile_image.paste(cropped_digit_image, ((TILE_WIDTH_PIXELS-digit_width)/2, (TILE_HEIGHT_PIXELS-digit_height)/2))
-
-        tile_image = ImageOps.invert(tile_image)
-
-        tile_image.save(OUTPUT_IMAGE_FILEPATH_TEMPLATE % digit)
-
-        meta_data_entries.append(META_DATA_TEMPLATE % (digit, digit))
-
-
-    # Display the meta data which needs to be included in `resource_map.json`.
-    print ",\n".join(meta_data_entries)
-
-
-
+    if "--metadata-only" not in sys.argv[1:]:
+        render_tiles()
 
+    for project in PROJECTS:
+        update_package(project)
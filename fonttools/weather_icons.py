@@ -0,0 +1,95 @@
+#
+# Used to pack the weather condition icons of simplef-termo into one raw
+# resource per display type.
+#
+# This script should be run from the root of the repository, like this:
+#
+#    python3 fonttools/weather_icons.py
+#
+# It reads the text drawings of `ICONS_FILE_PATH` (a name line followed
+# by one line of `#` and `.` per pixel row, `#` being ink) and writes
+# `weather_icons~bw.bin` and `weather_icons~color.bin` next to the other
+# resources, so termo.c can load a single icon with
+# `resource_load_byte_range()` straight into its bitmap.
+#
+# Both files start with an index header, all fields little-endian:
+#
+#    uint8  count, width, height, row size in bytes
+#    uint16 offset of every icon from the start of the file
+#
+# followed by the icons, rows padded to the row size. Black and white
+# platforms get `GBitmapFormat1Bit` rows (least significant bit first,
+# padded to 32 bits, ink cleared) and color platforms get
+# `GBitmapFormat1BitPalette` rows (most significant bit first, padded to
+# 8 bits, ink set). Output only depends on the text file, so re-running
+# the script on unchanged inputs gives byte-identical files.
+#
+
+import struct
+
+ICONS_FILE_PATH = "resources/icons/weather.txt"
+OUTPUT_FILEPATH_TEMPLATE = "resources/data/weather_icons~%s.bin"
+
+HEADER_FORMAT = "<BBBB"
+OFFSET_FORMAT = "<H"
+
+
+def read_icons(path):
+    icons = []
+    with open(path) as icons_file:
+        for line in icons_file:
+            line = line.strip()
+            if not line:
+                continue
+            if set(line) <= set("#."):
+                icons[-1][1].append(line)
+            elif not line.startswith("#"):
+                icons.append((line, []))
+
+    width = len(icons[0][1][0])
+    height = len(icons[0][1])
+    for name, rows in icons:
+        if len(rows) != height or any(len(row) != width for row in rows):
+            raise ValueError("%s is not %dx%d" % (name, width, height))
+    return icons, width, height
+
+
+def pack_row(row, row_size, msb_first, ink_bit):
+    data = bytearray(row_size)
+    for x, pixel in enumerate(row):
+        if (pixel == "#") != bool(ink_bit):
+            continue
+        shift = 7 - x % 8 if msb_first else x % 8
+        data[x // 8] |= 1 << shift
+    if not ink_bit:
+        # padding stays paper
+        for x in range(len(row), row_size * 8):
+            data[x // 8] |= 1 << (7 - x % 8 if msb_first else x % 8)
+    return bytes(data)
+
+
+def pack(icons, width, height, row_size, msb_first, ink_bit):
+    header_size = struct.calcsize(HEADER_FORMAT) + struct.calcsize(OFFSET_FORMAT) * len(icons)
+    icon_size = row_size * height
+
+    data = struct.pack(HEADER_FORMAT, len(icons), width, height, row_size)
+    for i in range(len(icons)):
+        data += struct.pack(OFFSET_FORMAT, header_size + i * icon_size)
+    for name, rows in icons:
+        data += b"".join(pack_row(row, row_size, msb_first, ink_bit) for row in rows)
+    return data
+
+
+if __name__ == "__main__":
+    icons, width, height = read_icons(ICONS_FILE_PATH)
+
+    outputs = {
+        "bw": pack(icons, width, height, (width + 31) // 32 * 4, False, 0),
+        "color": pack(icons, width, height, (width + 7) // 8, True, 1),
+    }
+    for tag, data in sorted(outputs.items()):
+        with open(OUTPUT_FILEPATH_TEMPLATE % tag, "wb") as output_file:
+            output_file.write(data)
+
+    for code, (name, rows) in enumerate(icons, 1):
+        print("%d %s" % (code, name))
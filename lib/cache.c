@@ -0,0 +1,160 @@
+#include "pebble.h"
+#include "cache.h"
+
+typedef struct {
+    GBitmap *cache;
+    bool valid;
+    // screen area the cache was captured from
+    GRect captured;
+    int16_t text_offset;
+    const char *text;
+    GFont font;
+    GColor color;
+    GTextAlignment alignment;
+} TextCacheData;
+
+// Copies the screen area under `frame` (window coordinates) into the
+// cache bitmap, creating it on first use. 1-bit caches hold whole screen
+// rows so no bit shifting is needed, 8-bit ones just the frame.
+GBitmap *cache_capture(GContext *ctx, GRect frame, GBitmap *cache) {
+    GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+    if (!frame_buffer) {
+        return cache;
+    }
+
+    GRect screen = gbitmap_get_bounds(frame_buffer);
+    #ifdef PBL_BW
+    GSize size = GSize(screen.size.w, frame.size.h);
+    #else
+    GSize size = frame.size;
+    int offset_x = frame.origin.x;
+    #endif
+
+    if (!cache) {
+        cache = gbitmap_create_blank(size, PBL_IF_BW_ELSE(GBitmapFormat1Bit, GBitmapFormat8Bit));
+    }
+
+    if (cache) {
+        uint8_t *data = gbitmap_get_data(cache);
+        uint16_t stride = gbitmap_get_bytes_per_row(cache);
+        for (int y = 0; y < size.h; y++) {
+            int screen_y = frame.origin.y + y;
+            if (screen_y < 0 || screen_y >= screen.size.h) {
+                continue;
+            }
+            GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame_buffer, screen_y);
+            #ifdef PBL_BW
+            memcpy(data + y * stride, row.data, stride);
+            #else
+            int min_x = row.min_x > offset_x ? row.min_x : offset_x;
+            int max_x = row.max_x < offset_x + size.w - 1 ? row.max_x : offset_x + size.w - 1;
+            if (max_x >= min_x) {
+                memcpy(data + y * stride + (min_x - offset_x), row.data + min_x, max_x - min_x + 1);
+            }
+            #endif
+        }
+    }
+
+    graphics_release_frame_buffer(ctx, frame_buffer);
+    return cache;
+}
+
+// Draws a cache made by cache_capture() for the same frame, in the
+// coordinates of the layer whose frame it is.
+void cache_draw(GContext *ctx, GBitmap *cache, GRect frame) {
+    #ifdef PBL_BW
+    GRect rect = gbitmap_get_bounds(cache);
+    rect.origin.x = -frame.origin.x;
+    #else
+    GRect rect = GRect(0, 0, frame.size.w, frame.size.h);
+    #endif
+    graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+    graphics_draw_bitmap_in_rect(ctx, cache, rect);
+}
+
+static void text_cache_update_callback(Layer *layer, GContext* ctx) {
+    TextCacheData *data = layer_get_data(layer);
+    GRect frame = layer_get_frame(layer);
+
+    // a moved layer captures again, the old pixels are from elsewhere
+    if (data->valid && grect_equal(&frame, &data->captured)) {
+        cache_draw(ctx, data->cache, frame);
+        return;
+    }
+
+    if (data->text) {
+        GRect bounds = layer_get_bounds(layer);
+        bounds.origin.y += data->text_offset;
+        bounds.size.h -= data->text_offset;
+        graphics_context_set_text_color(ctx, data->color);
+        graphics_draw_text(ctx, data->text, data->font, bounds,
+                           GTextOverflowModeWordWrap, data->alignment, NULL);
+    }
+
+    // Only layers on the root layer are cached: their frame is in
+    // screen coordinates. The capture holds whatever is under the frame,
+    // so cached layers must not overlap.
+    data->cache = cache_capture(ctx, frame, data->cache);
+    data->valid = data->cache != NULL;
+    data->captured = frame;
+}
+
+// public methods
+Layer *text_cache_layer_create(GRect frame) {
+    Layer *layer = layer_create_with_data(frame, sizeof(TextCacheData));
+    TextCacheData *data = layer_get_data(layer);
+    data->cache = NULL;
+    data->valid = false;
+    data->captured = GRectZero;
+    data->text_offset = 0;
+    data->text = NULL;
+    data->font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+    data->color = GColorBlack;
+    data->alignment = GTextAlignmentLeft;
+    layer_set_update_proc(layer, text_cache_update_callback);
+    return layer;
+}
+
+void text_cache_layer_destroy(Layer *layer) {
+    TextCacheData *data = layer_get_data(layer);
+    if (data->cache) {
+        gbitmap_destroy(data->cache);
+    }
+    layer_destroy(layer);
+}
+
+void text_cache_layer_invalidate(Layer *layer) {
+    TextCacheData *data = layer_get_data(layer);
+    data->valid = false;
+    layer_mark_dirty(layer);
+}
+
+void text_cache_layer_set_text(Layer *layer, const char *text) {
+    TextCacheData *data = layer_get_data(layer);
+    data->text = text;
+    text_cache_layer_invalidate(layer);
+}
+
+void text_cache_layer_set_text_color(Layer *layer, GColor color) {
+    TextCacheData *data = layer_get_data(layer);
+    data->color = color;
+    text_cache_layer_invalidate(layer);
+}
+
+void text_cache_layer_set_font(Layer *layer, GFont font) {
+    TextCacheData *data = layer_get_data(layer);
+    data->font = font;
+    text_cache_layer_invalidate(layer);
+}
+
+void text_cache_layer_set_text_offset(Layer *layer, int16_t offset) {
+    TextCacheData *data = layer_get_data(layer);
+    data->text_offset = offset;
+    text_cache_layer_invalidate(layer);
+}
+
+void text_cache_layer_set_text_alignment(Layer *layer, GTextAlignment alignment) {
+    TextCacheData *data = layer_get_data(layer);
+    data->alignment = alignment;
+    text_cache_layer_invalidate(layer);
+}
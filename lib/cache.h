@@ -0,0 +1,23 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+// Offscreen copies of rendered screen areas, for content that changes
+// far less often than the window is redrawn.
+GBitmap *cache_capture(GContext *ctx, GRect frame, GBitmap *cache);
+void cache_draw(GContext *ctx, GBitmap *cache, GRect frame);
+
+// Text layer that lays out and rasterizes its text once, then blits the
+// cached pixels until the text, font, colors or frame change. Cached
+// layers must not overlap: a capture holds everything under the frame.
+Layer *text_cache_layer_create(GRect frame);
+void text_cache_layer_destroy(Layer *layer);
+void text_cache_layer_set_text(Layer *layer, const char *text);
+void text_cache_layer_set_text_color(Layer *layer, GColor color);
+void text_cache_layer_set_font(Layer *layer, GFont font);
+void text_cache_layer_set_text_alignment(Layer *layer, GTextAlignment alignment);
+// Moves the text down by `offset` rows, or up when negative, so its
+// blank top rows can stay outside the frame.
+void text_cache_layer_set_text_offset(Layer *layer, int16_t offset);
+void text_cache_layer_invalidate(Layer *layer);
+
+#endif /* CACHE_H */
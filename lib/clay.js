@@ -9,6 +9,19 @@ const clayConfig = [
         "label": "Inverse colors",
         "defaultValue": false
     },
+    {
+        "type": "select",
+        "messageKey": "THEME",
+        "label": "Color theme",
+        "defaultValue": "0",
+        "capabilities": ["COLOR"],
+        "options": [
+            { "label": "Classic", "value": "0" },
+            { "label": "Ocean", "value": "1" },
+            { "label": "Forest", "value": "2" },
+            { "label": "Amber", "value": "3" }
+        ]
+    },
     {
         "type": "submit",
         "defaultValue": "Save Settings"
@@ -0,0 +1,105 @@
+#include "pebble.h"
+#include "vars.h"
+#include "layout.auto.h"
+#include "render_stats.h"
+#include "soak_stats.h"
+#include "glance.h"
+#include "theme.h"
+
+// Extra info shown for a few seconds on wrist flick. The overlay layer
+// and its text buffer are allocated once at init and only shown and
+// hidden, so a flick never touches the heap.
+#define GLANCE_DURATION 4000
+#define GLANCE_TEXT_SIZE 96
+#define GLANCE_FONT_KEY FONT_KEY_GOTHIC_18
+
+static GlanceTextHandler glance_handler;
+static bool glance_inverse = false;
+
+static Layer *layer_glance;
+static AppTimer *glance_timer;
+static char glance_text[GLANCE_TEXT_SIZE];
+
+static GRect text_box(GRect bounds) {
+    return GRect(4, 2, bounds.size.w - 8, bounds.size.h - 4);
+}
+
+static void glance_layer_update_callback(Layer *layer, GContext* ctx) {
+    GRect bounds = layer_get_bounds(layer);
+
+    graphics_context_set_fill_color(ctx, theme_background(glance_inverse));
+    graphics_fill_rect(ctx, bounds, 4, GCornersAll);
+    graphics_context_set_stroke_color(ctx, theme_foreground(glance_inverse));
+    graphics_draw_round_rect(ctx, bounds, 4);
+
+    graphics_context_set_text_color(ctx, theme_foreground(glance_inverse));
+    graphics_draw_text(ctx, glance_text, fonts_get_system_font(GLANCE_FONT_KEY), text_box(bounds),
+                       GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter, NULL);
+}
+
+static void hide_glance(void) {
+    if (glance_timer) {
+        app_timer_cancel(glance_timer);
+        glance_timer = NULL;
+    }
+    layer_set_hidden(layer_glance, true);
+}
+
+static void handle_glance_timeout(void *data) {
+    glance_timer = NULL;
+    hide_glance();
+}
+
+// The texts are kept to two short lines per module (see
+// status_glance_text and termo_glance_text) to fit LAYOUT_GLANCE.
+static void check_text_fits(void) {
+    GRect box = text_box(layer_get_bounds(layer_glance));
+    GSize size = graphics_text_layout_get_content_size(glance_text, fonts_get_system_font(GLANCE_FONT_KEY),
+                                                       GRect(0, 0, box.size.w, 1000),
+                                                       GTextOverflowModeWordWrap, GTextAlignmentCenter);
+    if (size.h > box.size.h) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "glance text is %d px high, the layout has %d", size.h, box.size.h);
+    }
+}
+
+static void handle_tap(AccelAxisType axis, int32_t direction) {
+    soak_stats_wakeup();
+
+    // Another flick keeps the glance on screen
+    if (glance_timer) {
+        app_timer_reschedule(glance_timer, GLANCE_DURATION);
+        return;
+    }
+
+    glance_handler(glance_text, sizeof(glance_text));
+    check_text_fits();
+    layer_mark_dirty(layer_glance);
+    layer_set_hidden(layer_glance, false);
+
+    glance_timer = app_timer_register(GLANCE_DURATION, handle_glance_timeout, NULL);
+}
+
+// public methods
+void glance_set_style(bool inverse) {
+    glance_inverse = inverse;
+    layer_mark_dirty(layer_glance);
+}
+
+void glance_init(Window* window, GlanceTextHandler handler) {
+    Layer *window_layer = window_get_root_layer(window);
+    glance_handler = handler;
+
+    // on top of everything, hidden until a flick
+    layer_glance = layer_create(LAYOUT_RECTS[LAYOUT_GLANCE]);
+    layer_set_update_proc(layer_glance, glance_layer_update_callback);
+    layer_set_hidden(layer_glance, true);
+    layer_add_child(window_layer, layer_glance);
+
+    accel_tap_service_subscribe(handle_tap);
+}
+
+void glance_deinit(void) {
+    accel_tap_service_unsubscribe();
+    hide_glance();
+    layer_destroy(layer_glance);
+}
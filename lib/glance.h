@@ -0,0 +1,11 @@
+#ifndef GLANCE_H
+#define GLANCE_H
+
+// Fills the overlay text, returns its length.
+typedef int (*GlanceTextHandler)(char *buffer, size_t size);
+
+void glance_init(Window* window, GlanceTextHandler handler);
+void glance_deinit(void);
+void glance_set_style(bool inverse);
+
+#endif /* GLANCE_H */
@@ -0,0 +1,115 @@
+#include "pebble.h"
+#include "vars.h"
+#include "layout.auto.h"
+#include "render_stats.h"
+#include "soak_stats.h"
+#include "health.h"
+#include "theme.h"
+
+#if defined(PBL_HEALTH)
+
+// Only redraw when the displayed value moves to the next bucket.
+#define STEPS_BUCKET 100
+
+static TextLayer *s_steps_layer;
+static int steps_bucket = -1;
+
+static char steps_layer_buffer[] = "100000";
+
+// Last shown bucket, kept between launches: health_service_sum_today()
+// is slow right after launch, so the first frame is drawn from it.
+typedef struct {
+    time_t day;
+    int32_t bucket;
+} StepsSnapshot;
+
+static StepsSnapshot snapshot;
+static AppTimer *steps_timer;
+
+static void show_steps(int bucket) {
+    if (bucket == steps_bucket) {
+        return;
+    }
+    steps_bucket = bucket;
+
+    snprintf(steps_layer_buffer, sizeof(steps_layer_buffer), "%d", bucket * STEPS_BUCKET);
+    text_layer_set_text(s_steps_layer, steps_layer_buffer);
+}
+
+static void update_steps(void) {
+    // the live read is already on its way
+    if (steps_timer) {
+        return;
+    }
+    show_steps(health_service_sum_today(HealthMetricStepCount) / STEPS_BUCKET);
+}
+
+static void handle_steps_timer(void *data) {
+    steps_timer = NULL;
+    update_steps();
+}
+
+static void handle_health(HealthEventType event, void *context) {
+    soak_stats_wakeup();
+
+    // Movement updates come often, but only bucket changes get drawn.
+    if (event != HealthEventSleepUpdate) {
+        update_steps();
+    }
+}
+
+// public methods
+void health_set_style(bool inverse) {
+    GColor foreground_color  = theme_foreground(inverse);
+    text_layer_set_text_color(s_steps_layer, foreground_color);
+}
+
+void health_update_time(struct tm *tick_time) {
+    update_steps();
+}
+
+void health_init(Window* window) {
+    Layer *window_layer = window_get_root_layer(window);
+
+    s_steps_layer = text_layer_create(LAYOUT_RECTS[LAYOUT_HEALTH_STEPS]);
+    text_layer_set_background_color(s_steps_layer, GColorClear);
+    text_layer_set_text_alignment(s_steps_layer, GTextAlignmentCenter);
+    text_layer_set_font(s_steps_layer, fonts_get_system_font(FONT_KEY_ROBOTO_CONDENSED_21));
+    layer_add_child(window_layer, text_layer_get_layer(s_steps_layer));
+
+    // first frame from today's snapshot, the timer reads the live value
+    if (persist_read_data(STEPS_SNAPSHOT_KEY, &snapshot, sizeof(snapshot)) == sizeof(snapshot)
+            && snapshot.day == time_start_of_today()) {
+        show_steps(snapshot.bucket);
+        steps_timer = app_timer_register(0, handle_steps_timer, NULL);
+    }
+
+    health_service_events_subscribe(handle_health, NULL);
+}
+
+void health_deinit(void) {
+    health_service_events_unsubscribe();
+    if (steps_timer) {
+        app_timer_cancel(steps_timer);
+        steps_timer = NULL;
+    }
+
+    // only written when the shown value moved
+    if (steps_bucket >= 0 && (steps_bucket != snapshot.bucket || snapshot.day != time_start_of_today())) {
+        snapshot.day = time_start_of_today();
+        snapshot.bucket = steps_bucket;
+        persist_write_data(STEPS_SNAPSHOT_KEY, &snapshot, sizeof(snapshot));
+    }
+
+    text_layer_destroy(s_steps_layer);
+}
+
+#else
+
+// No Health on this platform: the widget is compiled out.
+void health_set_style(bool inverse) {}
+void health_update_time(struct tm *tick_time) {}
+void health_init(Window* window) {}
+void health_deinit(void) {}
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef HEALTH_H
+#define HEALTH_H
+ 
+void health_init(Window* window);
+void health_deinit(void);
+void health_set_style(bool inverse);
+void health_update_time(struct tm *tick_time);
+
+#endif /* HEALTH_H */
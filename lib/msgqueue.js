@@ -0,0 +1,78 @@
+// Serialized AppMessage sending. Everything queued during one event
+// loop turn goes out as a single merged dictionary, the next one only
+// after the watch has acknowledged the previous one, and NACKed
+// dictionaries are retried with exponential backoff.
+var RETRY_LIMIT = 5;
+var RETRY_BASE_DELAY = 1000;
+
+var pending = null;
+var pendingCallbacks = [];
+var sending = false;
+var retries = 0;
+var flushTimer = null;
+
+function merge(target, source) {
+    Object.keys(source).forEach(function(key) {
+        target[key] = source[key];
+    });
+    return target;
+}
+
+function scheduleFlush(delay) {
+    if (flushTimer === null) {
+        flushTimer = setTimeout(flush, delay);
+    }
+}
+
+function flush() {
+    flushTimer = null;
+    if (sending || !pending) {
+        return;
+    }
+
+    var dictionary = pending;
+    var callbacks = pendingCallbacks;
+    pending = null;
+    pendingCallbacks = [];
+    sending = true;
+
+    Pebble.sendAppMessage(
+        dictionary,
+        function() {
+            sending = false;
+            retries = 0;
+            callbacks.forEach(function(callback) {
+                callback(dictionary);
+            });
+            scheduleFlush(0);
+        },
+        function(e) {
+            sending = false;
+            if (retries >= RETRY_LIMIT) {
+                console.log("Dropping message after " + retries + " retries: " + JSON.stringify(e));
+                retries = 0;
+                scheduleFlush(0);
+                return;
+            }
+
+            // newer values queued meanwhile win over the failed ones
+            pending = merge(dictionary, pending || {});
+            pendingCallbacks = callbacks.concat(pendingCallbacks);
+            scheduleFlush(RETRY_BASE_DELAY * Math.pow(2, retries++));
+        }
+    );
+}
+
+// Queues `dictionary` for the watch. `onSent` is called with the
+// dictionary that was actually delivered, which may hold more keys.
+function send(dictionary, onSent) {
+    pending = merge(pending || {}, dictionary);
+    if (onSent) {
+        pendingCallbacks.push(onSent);
+    }
+    scheduleFlush(0);
+}
+
+module.exports = {
+    send: send
+};
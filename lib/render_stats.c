@@ -0,0 +1,108 @@
+#include "pebble.h"
+#include "render_stats.h"
+#include "soak_stats.h"
+
+#ifdef RENDER_STATS
+
+// Two probe layers wrap the whole layer tree: the first child of the
+// root layer marks the frame start, the last one the frame end.
+static Layer *layer_frame_start;
+static Layer *layer_frame_end;
+
+// Every layer added to the window gets an empty child layer, which is
+// drawn right after it (and skipped with it when hidden), so text and
+// bitmap layers are counted as well as the custom ones.
+#define MAX_DRAW_PROBES 24
+
+static Layer *draw_probes[MAX_DRAW_PROBES];
+static int draw_probe_count = 0;
+
+static time_t start_s;
+static uint16_t start_ms;
+static uint32_t init_ms;
+
+static uint32_t frame_count = 0;
+static int frame_draws;
+static int32_t frame_area;
+
+static uint32_t now_ms(void) {
+    time_t s;
+    uint16_t ms;
+    time_ms(&s, &ms);
+    return (uint32_t)s * 1000 + ms;
+}
+
+static void frame_start_update_callback(Layer *layer, GContext* ctx) {
+    time_ms(&start_s, &start_ms);
+    frame_draws = 0;
+    frame_area = 0;
+}
+
+static void frame_end_update_callback(Layer *layer, GContext* ctx) {
+    uint32_t end = now_ms();
+    uint32_t duration = end - ((uint32_t)start_s * 1000 + start_ms);
+
+    if (frame_count == 0) {
+        APP_LOG(APP_LOG_LEVEL_INFO, "first frame %d ms after init", (int)(end - init_ms));
+    }
+    frame_count++;
+    soak_stats_redraw();
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "frame %d: %d ms, %d draws, %d px",
+            (int)frame_count, (int)duration, frame_draws, (int)frame_area);
+}
+
+static void draw_probe_update_callback(Layer *layer, GContext* ctx) {
+    Layer *parent = *(Layer **)layer_get_data(layer);
+    GRect bounds = layer_get_bounds(parent);
+    frame_draws++;
+    frame_area += bounds.size.w * bounds.size.h;
+}
+
+// The macro of render_stats.h doesn't apply to `(layer_add_child)`.
+void render_stats_add_child(Layer *parent, Layer *child) {
+    (layer_add_child)(parent, child);
+
+    if (draw_probe_count == MAX_DRAW_PROBES) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "too many layers, draws not counted");
+        return;
+    }
+    Layer *probe = layer_create_with_data(GRect(0, 0, 1, 1), sizeof(Layer *));
+    if (probe) {
+        *(Layer **)layer_get_data(probe) = child;
+        layer_set_update_proc(probe, draw_probe_update_callback);
+        (layer_add_child)(child, probe);
+        draw_probes[draw_probe_count++] = probe;
+    }
+}
+
+void render_stats_init(Window* window) {
+    Layer *window_layer = window_get_root_layer(window);
+    GRect bounds = layer_get_bounds(window_layer);
+
+    init_ms = now_ms();
+
+    layer_frame_start = layer_create(bounds);
+    layer_set_update_proc(layer_frame_start, frame_start_update_callback);
+    (layer_add_child)(window_layer, layer_frame_start);
+}
+
+void render_stats_attach(Window* window) {
+    Layer *window_layer = window_get_root_layer(window);
+
+    layer_frame_end = layer_create(layer_get_bounds(window_layer));
+    layer_set_update_proc(layer_frame_end, frame_end_update_callback);
+    (layer_add_child)(window_layer, layer_frame_end);
+}
+
+void render_stats_deinit(void) {
+    APP_LOG(APP_LOG_LEVEL_INFO, "%d frames rendered", (int)frame_count);
+    for (int i = 0; i < draw_probe_count; i++) {
+        layer_destroy(draw_probes[i]);
+    }
+    draw_probe_count = 0;
+    layer_destroy(layer_frame_end);
+    layer_destroy(layer_frame_start);
+}
+
+#endif
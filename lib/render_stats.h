@@ -0,0 +1,21 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+// Per-frame render timing, enabled with `--render-stats` at configure
+// time (see buildtools/instrument.py). Compiles to nothing otherwise.
+// Include it after pebble.h in every file that adds layers to the
+// window, so their draws are counted.
+#ifdef RENDER_STATS
+void render_stats_init(Window* window);
+void render_stats_attach(Window* window);
+void render_stats_deinit(void);
+void render_stats_add_child(Layer *parent, Layer *child);
+
+#define layer_add_child(parent, child) render_stats_add_child(parent, child)
+#else
+#define render_stats_init(window)
+#define render_stats_attach(window)
+#define render_stats_deinit()
+#endif
+
+#endif /* RENDER_STATS_H */
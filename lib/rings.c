@@ -0,0 +1,203 @@
+#include "pebble.h"
+#include "vars.h"
+#include "layout.auto.h"
+#include "render_stats.h"
+#include "rings.h"
+#include "theme.h"
+
+#if defined(PBL_ROUND)
+
+// Both rings are rasterized once into a 2-bit palettized bitmap and
+// blitted from there: graphics_fill_radial() only runs when a quantized
+// value changes, colors are swapped in the palette.
+#define BATTERY_RING_WIDTH 6
+#define PROGRESS_RING_INSET 9
+#define PROGRESS_RING_WIDTH 3
+// day progress moves every quarter of an hour
+#define PROGRESS_STEP_MINUTES 15
+
+// Palette entries, drawn in marker colors and then mapped back.
+#define RING_NONE 0
+#define RING_BATTERY 1
+#define RING_PROGRESS 2
+
+static Layer *layer_rings;
+static RingsChangeHandler change_handler;
+static GBitmap *rings_cache;
+static bool rings_valid = false;
+static GColor rings_palette[4];
+
+static bool rings_inverse = false;
+static int battery_level = -1;
+static int progress_step = -1;
+static BatteryChargeState battery_state;
+
+static GColor battery_color(void) {
+    if (battery_state.is_charging) {
+        return GColorGreen;
+    } else if (battery_state.charge_percent <= 20) {
+        return GColorRed;
+    } else if (battery_state.charge_percent <= 50) {
+        return GColorYellow;
+    }
+    return theme_accent();
+}
+
+// Returns whether the ring colors changed.
+static bool update_palette(void) {
+    GColor battery = battery_color();
+    GColor progress = theme_foreground(rings_inverse);
+    bool changed = !gcolor_equal(rings_palette[RING_BATTERY], battery)
+        || !gcolor_equal(rings_palette[RING_PROGRESS], progress);
+
+    rings_palette[RING_NONE] = GColorClear;
+    rings_palette[RING_BATTERY] = battery;
+    rings_palette[RING_PROGRESS] = progress;
+    rings_palette[3] = GColorClear;
+    return changed;
+}
+
+static void rings_changed(void) {
+    layer_mark_dirty(layer_rings);
+    if (change_handler) {
+        change_handler();
+    }
+}
+
+static void invalidate_rings(void) {
+    rings_valid = false;
+    rings_changed();
+}
+
+static void draw_markers(GContext *ctx, GRect bounds) {
+    graphics_context_set_antialiased(ctx, false);
+    graphics_context_set_fill_color(ctx, GColorBlack);
+    graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+
+    if (battery_level > 0) {
+        graphics_context_set_fill_color(ctx, GColorRed);
+        graphics_fill_radial(ctx, bounds, GOvalScaleModeFitCircle, BATTERY_RING_WIDTH,
+                             0, TRIG_MAX_ANGLE * battery_level / 10);
+    }
+
+    if (progress_step > 0) {
+        graphics_context_set_fill_color(ctx, GColorBlue);
+        graphics_fill_radial(ctx, grect_inset(bounds, GEdgeInsets(PROGRESS_RING_INSET)),
+                             GOvalScaleModeFitCircle, PROGRESS_RING_WIDTH,
+                             0, TRIG_MAX_ANGLE * progress_step / (24 * 60 / PROGRESS_STEP_MINUTES));
+    }
+    graphics_context_set_antialiased(ctx, true);
+}
+
+// Maps the marker colors under `frame` to palette indexes.
+static void capture_markers(GContext *ctx, GRect frame) {
+    GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+    if (!frame_buffer) {
+        return;
+    }
+
+    uint8_t *data = gbitmap_get_data(rings_cache);
+    uint16_t stride = gbitmap_get_bytes_per_row(rings_cache);
+    memset(data, 0, stride * frame.size.h);
+
+    for (int y = 0; y < frame.size.h; y++) {
+        GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame_buffer, frame.origin.y + y);
+        int min_x = row.min_x > frame.origin.x ? row.min_x : frame.origin.x;
+        int max_x = row.max_x < frame.origin.x + frame.size.w - 1 ? row.max_x : frame.origin.x + frame.size.w - 1;
+        for (int x = min_x; x <= max_x; x++) {
+            int index;
+            if (row.data[x] == GColorRedARGB8) {
+                index = RING_BATTERY;
+            } else if (row.data[x] == GColorBlueARGB8) {
+                index = RING_PROGRESS;
+            } else {
+                continue;
+            }
+            int cache_x = x - frame.origin.x;
+            data[y * stride + cache_x / 4] |= index << (6 - 2 * (cache_x % 4));
+        }
+    }
+
+    graphics_release_frame_buffer(ctx, frame_buffer);
+}
+
+static void rings_layer_update_callback(Layer *layer, GContext* ctx) {
+    GRect bounds = layer_get_bounds(layer);
+
+    if (!rings_cache) {
+        rings_cache = gbitmap_create_blank_with_palette(bounds.size, GBitmapFormat2BitPalette, rings_palette, false);
+        if (!rings_cache) {
+            return;
+        }
+    }
+
+    if (!rings_valid) {
+        // Drawn below everything else, so only the markers are captured.
+        draw_markers(ctx, bounds);
+        capture_markers(ctx, layer_get_frame(layer));
+        rings_valid = true;
+
+        graphics_context_set_fill_color(ctx, theme_background(rings_inverse));
+        graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+    }
+
+    graphics_context_set_compositing_mode(ctx, GCompOpSet);
+    graphics_draw_bitmap_in_rect(ctx, rings_cache, bounds);
+}
+
+// public methods
+void rings_set_style(bool inverse) {
+    rings_inverse = inverse;
+    if (update_palette()) {
+        rings_changed();
+    }
+}
+
+void rings_set_battery(BatteryChargeState charge_state) {
+    battery_state = charge_state;
+    bool recolored = update_palette();
+
+    // rounded up, so a nearly empty battery still shows a sliver
+    int new_battery_level = (charge_state.charge_percent + 9) / 10;
+    if (new_battery_level != battery_level) {
+        battery_level = new_battery_level;
+        invalidate_rings();
+    } else if (recolored) {
+        rings_changed();
+    }
+}
+
+void rings_update_time(struct tm *tick_time) {
+    int new_progress_step = (tick_time->tm_hour * 60 + tick_time->tm_min) / PROGRESS_STEP_MINUTES;
+    if (new_progress_step != progress_step) {
+        progress_step = new_progress_step;
+        invalidate_rings();
+    }
+}
+
+void rings_init(Window* window, RingsChangeHandler handler) {
+    change_handler = handler;
+    layer_rings = layer_create(LAYOUT_RECTS[LAYOUT_RINGS]);
+    layer_set_update_proc(layer_rings, rings_layer_update_callback);
+    layer_add_child(window_get_root_layer(window), layer_rings);
+
+    update_palette();
+}
+
+void rings_deinit(void) {
+    layer_destroy(layer_rings);
+    if (rings_cache) {
+        gbitmap_destroy(rings_cache);
+    }
+}
+
+#else
+
+// Rectangular displays keep the status corners.
+void rings_init(Window* window, RingsChangeHandler handler) {}
+void rings_deinit(void) {}
+void rings_set_style(bool inverse) {}
+void rings_set_battery(BatteryChargeState charge_state) {}
+void rings_update_time(struct tm *tick_time) {}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef RINGS_H
+#define RINGS_H
+
+// Battery and day progress rings along the bezel of round displays.
+// Compiled out elsewhere.
+
+// Called when the ring pixels change, for caches that captured them.
+typedef void (*RingsChangeHandler)(void);
+
+void rings_init(Window* window, RingsChangeHandler handler);
+void rings_deinit(void);
+void rings_set_style(bool inverse);
+void rings_set_battery(BatteryChargeState charge_state);
+void rings_update_time(struct tm *tick_time);
+
+#endif /* RINGS_H */
@@ -0,0 +1,49 @@
+#include "pebble.h"
+#include "schedule.h"
+#include "soak_stats.h"
+
+static ScheduleHandler schedule_handler;
+static AppTimer *flush_timer;
+static uint32_t pending_reasons = 0;
+
+static void handle_flush_timer(void *data) {
+    soak_stats_wakeup();
+    flush_timer = NULL;
+    schedule_flush();
+}
+
+// public methods
+void schedule_init(ScheduleHandler handler) {
+    schedule_handler = handler;
+}
+
+void schedule_deinit(void) {
+    if (flush_timer) {
+        app_timer_cancel(flush_timer);
+        flush_timer = NULL;
+    }
+    pending_reasons = 0;
+}
+
+// Requests an update. Everything requested during one event loop turn is
+// handled once, by a zero-delay timer.
+void schedule_update(uint32_t reasons) {
+    pending_reasons |= reasons;
+    if (!flush_timer) {
+        flush_timer = app_timer_register(0, handle_flush_timer, NULL);
+    }
+}
+
+// Handles pending requests right away.
+void schedule_flush(void) {
+    if (flush_timer) {
+        app_timer_cancel(flush_timer);
+        flush_timer = NULL;
+    }
+
+    uint32_t reasons = pending_reasons;
+    pending_reasons = 0;
+    if (reasons) {
+        schedule_handler(reasons);
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+// Reasons for a face update, collected until the next flush.
+#define UPDATE_STYLE  (1 << 0)
+#define UPDATE_STATUS (1 << 1)
+#define UPDATE_TIME   (1 << 2)
+#define UPDATE_BOUNDS (1 << 3)
+#define UPDATE_ALL    (UPDATE_STYLE | UPDATE_STATUS | UPDATE_TIME | UPDATE_BOUNDS)
+
+typedef void (*ScheduleHandler)(uint32_t reasons);
+
+void schedule_init(ScheduleHandler handler);
+void schedule_deinit(void);
+void schedule_update(uint32_t reasons);
+void schedule_flush(void);
+
+#endif /* SCHEDULE_H */
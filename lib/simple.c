@@ -1,16 +1,20 @@
 #include "pebble.h"
 #include "vars.h"
+#include "layout.auto.h"
+#include "render_stats.h"
+#include "cache.h"
 #include "simple.h"
+#include "theme.h"
 
-#define TIME_DIGIT_HEIGHT 52
-#define TIME_DISPLAY_MAX_Y 96
+// rows of the date text above its frame, see layout.json
+#define DATE_TEXT_OFFSET -2
 
 static Window *main_window;
 static Layer *main_window_layer;
 static GColor foreground_color;
 
-static TextLayer *layer_date_text;
-static TextLayer *layer_wday_text;
+static Layer *layer_date_text;
+static Layer *layer_wday_text;
 static TextLayer *layer_time_text;
 static Layer *layer_line;
 
@@ -18,13 +22,14 @@ static int cur_day = -1;
 
 
 static void line_layer_update_callback(Layer *layer, GContext* ctx) {
+    GRect bounds = layer_get_bounds(layer);
     graphics_context_set_fill_color(ctx, foreground_color);
-    graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
+    graphics_fill_rect(ctx, bounds, 0, GCornerNone);
 }
 
-static void layer_set_y(Layer *layer, int y) {
+static void layer_set_y(Layer *layer, LayoutId id, int shift) {
     GRect frame = layer_get_frame(layer);
-    frame.origin.y = y;
+    frame.origin.y = LAYOUT_RECTS[id].origin.y + shift;
     layer_set_frame(layer, frame);
 }
 
@@ -35,18 +40,19 @@ void simple_update_bounds(void) {
     // Get the total available screen real-estate
     GRect bounds = layer_get_unobstructed_bounds(main_window_layer);
 
-    int time_display_top = bounds.size.h - TIME_DIGIT_HEIGHT;
-    if (time_display_top > TIME_DISPLAY_MAX_Y) {
-        time_display_top = TIME_DISPLAY_MAX_Y;
+    // Move the time up only as far as needed to stay fully visible
+    int shift = bounds.size.h - LAYOUT_RECTS[LAYOUT_SIMPLE_TIME].size.h - LAYOUT_RECTS[LAYOUT_SIMPLE_LINE].origin.y;
+    if (shift > 0) {
+        shift = 0;
     }
 
-    layer_set_y(text_layer_get_layer(layer_time_text), time_display_top - 5);
-    layer_set_y(text_layer_get_layer(layer_date_text), time_display_top - 28);
-    layer_set_y(layer_line, time_display_top);
+    layer_set_y(text_layer_get_layer(layer_time_text), LAYOUT_SIMPLE_TIME, shift);
+    layer_set_y(layer_date_text, LAYOUT_SIMPLE_DATE, shift);
+    layer_set_y(layer_line, LAYOUT_SIMPLE_LINE, shift);
 
     // Hide the date if screen is obstructed
     bool hide_date = !grect_equal(&full_bounds, &bounds);
-    layer_set_hidden(text_layer_get_layer(layer_wday_text), hide_date);
+    layer_set_hidden(layer_wday_text, hide_date);
 }
 
 void simple_update_time(struct tm *tick_time) {
@@ -63,10 +69,10 @@ void simple_update_time(struct tm *tick_time) {
         cur_day = new_cur_day;
         
         strftime(date_text, sizeof(date_text), "%B %e", tick_time);
-        text_layer_set_text(layer_date_text, date_text);
+        text_cache_layer_set_text(layer_date_text, date_text);
 
         strftime(wday_text, sizeof(wday_text), "%A", tick_time);
-        text_layer_set_text(layer_wday_text, wday_text);
+        text_cache_layer_set_text(layer_wday_text, wday_text);
     }
 
     if (clock_is_24h_style()) {
@@ -87,11 +93,11 @@ void simple_update_time(struct tm *tick_time) {
 }
 
 void simple_set_style(bool inverse) {
-    foreground_color  = inverse ? GColorBlack : GColorWhite;
+    foreground_color  = theme_foreground(inverse);
     
     text_layer_set_text_color(layer_time_text, foreground_color);
-    text_layer_set_text_color(layer_wday_text, foreground_color);
-    text_layer_set_text_color(layer_date_text, foreground_color);
+    text_cache_layer_set_text_color(layer_wday_text, foreground_color);
+    text_cache_layer_set_text_color(layer_date_text, foreground_color);
 }
 
 void simple_init(Window* window) {
@@ -99,36 +105,27 @@ void simple_init(Window* window) {
     main_window_layer = window_get_root_layer(window);
     foreground_color = GColorBlack;
 
-    // Get the total available screen real-estate
-    GRect bounds = layer_get_bounds(main_window_layer);
-
-    int padding = (bounds.size.w - 144) / 2;
-
     // layers
-    layer_time_text = text_layer_create(GRect(7, TIME_DISPLAY_MAX_Y - 5, bounds.size.w-14, TIME_DIGIT_HEIGHT));
+    layer_time_text = text_layer_create(LAYOUT_RECTS[LAYOUT_SIMPLE_TIME]);
 
-    layer_wday_text = text_layer_create(GRect(8, 47, bounds.size.w-16, 23));
-    layer_date_text = text_layer_create(GRect(8, TIME_DISPLAY_MAX_Y - 28, bounds.size.w-16, 23));
+    layer_wday_text = text_cache_layer_create(LAYOUT_RECTS[LAYOUT_SIMPLE_WDAY]);
+    layer_date_text = text_cache_layer_create(LAYOUT_RECTS[LAYOUT_SIMPLE_DATE]);
     
     text_layer_set_text_alignment(layer_time_text, GTextAlignmentCenter);
-    text_layer_set_text_alignment(layer_wday_text, GTextAlignmentLeft);
-    text_layer_set_text_alignment(layer_date_text, GTextAlignmentLeft);
+    text_cache_layer_set_text_alignment(layer_wday_text, GTextAlignmentLeft);
+    text_cache_layer_set_text_alignment(layer_date_text, GTextAlignmentLeft);
 
-    layer_line      = layer_create(GRect(
-        padding + 8,
-        TIME_DISPLAY_MAX_Y,
-        128,
-        2
-    ));
+    layer_line      = layer_create(LAYOUT_RECTS[LAYOUT_SIMPLE_LINE]);
 
     text_layer_set_background_color(layer_time_text, GColorClear);
     text_layer_set_font(layer_time_text, fonts_get_system_font(FONT_KEY_ROBOTO_BOLD_SUBSET_49));
 
-    text_layer_set_background_color(layer_wday_text, GColorClear);
-    text_layer_set_font(layer_wday_text, fonts_get_system_font(FONT_KEY_ROBOTO_CONDENSED_21));
+    text_cache_layer_set_font(layer_wday_text, fonts_get_system_font(FONT_KEY_ROBOTO_CONDENSED_21));
 
-    text_layer_set_background_color(layer_date_text, GColorClear);
-    text_layer_set_font(layer_date_text, fonts_get_system_font(FONT_KEY_ROBOTO_CONDENSED_21));
+    text_cache_layer_set_font(layer_date_text, fonts_get_system_font(FONT_KEY_ROBOTO_CONDENSED_21));
+    // The date frame starts below the weekday one, whose text reaches
+    // into the (blank) top rows of the date line.
+    text_cache_layer_set_text_offset(layer_date_text, DATE_TEXT_OFFSET);
 
     layer_set_update_proc(layer_line, line_layer_update_callback);
 
@@ -136,15 +133,15 @@ void simple_init(Window* window) {
     Layer *window_layer = window_get_root_layer(window);
 
     layer_add_child(main_window_layer, text_layer_get_layer(layer_time_text));
-    layer_add_child(main_window_layer, text_layer_get_layer(layer_wday_text));
-    layer_add_child(main_window_layer, text_layer_get_layer(layer_date_text));
+    layer_add_child(main_window_layer, layer_wday_text);
+    layer_add_child(main_window_layer, layer_date_text);
     layer_add_child(window_layer, layer_line);
 }
 
 void simple_deinit(void) {
     text_layer_destroy(layer_time_text);
-    text_layer_destroy(layer_wday_text);
-    text_layer_destroy(layer_date_text);
+    text_cache_layer_destroy(layer_wday_text);
+    text_cache_layer_destroy(layer_date_text);
     layer_destroy(layer_line);
 }
 
@@ -1,25 +1,39 @@
 #include "pebble.h"
 #include "vars.h"
+#include "layout.auto.h"
+#include "render_stats.h"
+#include "cache.h"
 #include "simplebig.h"
+#include "theme.h"
 
 #define TOTAL_IMAGE_SLOTS 4
 
 #define NUMBER_OF_IMAGES 10
+// slot frames come from layout.json, see buildtools/layout.py
+#define DIGIT_IMAGE_HEIGHT (LAYOUT_RECTS[LAYOUT_BIG_DIGIT_0].size.h)
 #if defined(PBL_PLATFORM_EMERY)
-#define DIGIT_IMAGE_WIDTH 48
-#define DIGIT_IMAGE_HEIGHT 114
-#define LAYOUT_WIDTH 200
 #define DATE_FONT_KEY FONT_KEY_GOTHIC_28
-#define DATE_FONT_LINE_HEIGHT 30
 #else
-#define DIGIT_IMAGE_WIDTH 34
-#define DIGIT_IMAGE_HEIGHT 84
-#define LAYOUT_WIDTH 144
 #define DATE_FONT_KEY FONT_KEY_ROBOTO_CONDENSED_21
-#define DATE_FONT_LINE_HEIGHT 24
 #endif
 #define EMPTY_SLOT -1
 
+#ifdef DIGIT_ANIMATION
+#define DIGIT_ANIMATION_DURATION 300
+// hard cap on redraws per transition, whatever the frame rate is
+#define DIGIT_ANIMATION_MAX_FRAMES 10
+// don't animate below this charge unless charging
+#define DIGIT_ANIMATION_MIN_CHARGE 30
+#endif
+
+// `./waf configure --digit-blit` defines DIGIT_FB_BLIT, which copies the
+// digit glyphs straight into the frame buffer instead of compositing them
+// through the BitmapLayers, which then only keep the slot geometry.
+
+static const LayoutId DIGIT_LAYOUT_IDS[TOTAL_IMAGE_SLOTS] = {
+    LAYOUT_BIG_DIGIT_0, LAYOUT_BIG_DIGIT_1, LAYOUT_BIG_DIGIT_2, LAYOUT_BIG_DIGIT_3
+};
+
 // generated by the `fonttools/font2png.py` script.
 static const int IMAGE_RESOURCE_IDS[NUMBER_OF_IMAGES] = {
     RESOURCE_ID_IMAGE_NUM_0, RESOURCE_ID_IMAGE_NUM_1, RESOURCE_ID_IMAGE_NUM_2,
@@ -38,7 +52,7 @@ static BitmapLayer *digit_layers[TOTAL_IMAGE_SLOTS];
 
 static int image_slot_state[TOTAL_IMAGE_SLOTS] = {EMPTY_SLOT, EMPTY_SLOT, EMPTY_SLOT, EMPTY_SLOT};
 
-static TextLayer *layer_date_text;
+static Layer *layer_date_text;
 static Layer *layer_line;
 static Layer *layer_line_bott;
 
@@ -46,6 +60,16 @@ static BitmapLayer *layer_sep_img;
 static GBitmap *img_dig_separator;
 static int cur_day = -1;
 
+#ifdef DIGIT_FB_BLIT
+static Layer *layer_digits;
+#endif
+
+#ifdef DIGIT_ANIMATION
+static Animation *digit_animation;
+static int pending_digits[TOTAL_IMAGE_SLOTS] = {EMPTY_SLOT, EMPTY_SLOT, EMPTY_SLOT, EMPTY_SLOT};
+static int animated_slots = 0;
+static int animation_frames = 0;
+#endif
 
 static void load_digit_image_into_slot(int slot_number, int digit_value) {
 
@@ -63,14 +87,133 @@ static void load_digit_image_into_slot(int slot_number, int digit_value) {
 
     GBitmap* oldBitmap = digit_images[slot_number];
     digit_images[slot_number] = gbitmap_create_with_resource(IMAGE_RESOURCE_IDS[digit_value]);
+    #ifdef PBL_COLOR
+    theme_recolor(digit_images[slot_number], foreground_color);
+    #endif
     BitmapLayer *bitmap_layer = digit_layers[slot_number];
+    #ifdef DIGIT_FB_BLIT
+    layer_mark_dirty(layer_digits);
+    #else
     bitmap_layer_set_bitmap(bitmap_layer, digit_images[slot_number]);
+    #endif
     layer_set_hidden(bitmap_layer_get_layer(bitmap_layer), false);
     gbitmap_destroy(oldBitmap);
     image_slot_state[slot_number] = digit_value;
 }
 
+#ifdef DIGIT_ANIMATION
+static void set_digit_offset(int slot_number, int offset) {
+    Layer *layer = bitmap_layer_get_layer(digit_layers[slot_number]);
+    GRect bounds = layer_get_bounds(layer);
+    bounds.origin.y = offset;
+    layer_set_bounds(layer, bounds);
+}
+
+static void swap_pending_digits(void) {
+    for (int i = 0; i < TOTAL_IMAGE_SLOTS; i++) {
+        if (pending_digits[i] != EMPTY_SLOT) {
+            load_digit_image_into_slot(i, pending_digits[i]);
+            pending_digits[i] = EMPTY_SLOT;
+        }
+    }
+}
+
+static void finish_digit_animation(void) {
+    swap_pending_digits();
+    for (int i = 0; i < TOTAL_IMAGE_SLOTS; i++) {
+        if (animated_slots & (1 << i)) {
+            set_digit_offset(i, 0);
+        }
+    }
+    animated_slots = 0;
+}
+
+// Slides the old glyph up and out, then the new one in from below, by
+// moving the bounds of the slot layers. Glyphs are swapped in place at
+// the half-way point, so no intermediate frames are ever allocated.
+static void digit_animation_update(Animation *animation, const AnimationProgress progress) {
+    if (!animated_slots) {
+        return;
+    }
+    if (++animation_frames > DIGIT_ANIMATION_MAX_FRAMES) {
+        finish_digit_animation();
+        return;
+    }
+
+    int half = ANIMATION_NORMALIZED_MAX / 2;
+    int offset;
+    if (progress < half) {
+        offset = -DIGIT_IMAGE_HEIGHT * progress / half;
+    } else {
+        swap_pending_digits();
+        offset = DIGIT_IMAGE_HEIGHT * (ANIMATION_NORMALIZED_MAX - progress) / half;
+    }
+
+    for (int i = 0; i < TOTAL_IMAGE_SLOTS; i++) {
+        if (animated_slots & (1 << i)) {
+            set_digit_offset(i, offset);
+        }
+    }
+}
+
+static void digit_animation_teardown(Animation *animation) {
+    if (animation == digit_animation) {
+        finish_digit_animation();
+        digit_animation = NULL;
+    }
+}
+
+static const AnimationImplementation digit_animation_implementation = {
+    .update = digit_animation_update,
+    .teardown = digit_animation_teardown,
+};
+
+static bool digit_animation_allowed(void) {
+    BatteryChargeState charge_state = battery_state_service_peek();
+    return charge_state.is_charging || charge_state.charge_percent > DIGIT_ANIMATION_MIN_CHARGE;
+}
+
+static void start_digit_animation(void) {
+    if (!animated_slots) {
+        return;
+    }
+
+    animation_frames = 0;
+    digit_animation = animation_create();
+    animation_set_duration(digit_animation, DIGIT_ANIMATION_DURATION);
+    animation_set_curve(digit_animation, AnimationCurveEaseInOut);
+    animation_set_implementation(digit_animation, &digit_animation_implementation);
+    animation_schedule(digit_animation);
+}
+
+static void stop_digit_animation(void) {
+    if (digit_animation) {
+        Animation *animation = digit_animation;
+        digit_animation = NULL;
+        animation_unschedule(animation);
+    }
+    finish_digit_animation();
+}
+#endif
+
+static void set_digit(int slot_number, int digit_value) {
+    #ifdef DIGIT_ANIMATION
+    // Only slots already showing another digit are animated.
+    if (digit_animation_allowed()
+            && image_slot_state[slot_number] != EMPTY_SLOT
+            && image_slot_state[slot_number] != digit_value) {
+        pending_digits[slot_number] = digit_value;
+        animated_slots |= 1 << slot_number;
+        return;
+    }
+    #endif
+    load_digit_image_into_slot(slot_number, digit_value);
+}
+
 static void unload_digit_image_from_slot(int slot_number) {
+    #ifdef DIGIT_ANIMATION
+    pending_digits[slot_number] = EMPTY_SLOT;
+    #endif
     if (image_slot_state[slot_number] != EMPTY_SLOT) {
         layer_set_hidden(bitmap_layer_get_layer(digit_layers[slot_number]), true);
         image_slot_state[slot_number] = EMPTY_SLOT;
@@ -82,7 +225,7 @@ static void display_time_value(unsigned short value, unsigned short row_number,
     for (int column_number = 1; column_number >= 0; column_number--) {
         int slot_number = (row_number * 2) + column_number;
         if (!((value == 0) && (column_number == 0) && !show_first_leading_zero)) {
-            load_digit_image_into_slot(slot_number, value % 10);
+            set_digit(slot_number, value % 10);
         } else {
             unload_digit_image_from_slot(slot_number);
         }
@@ -98,14 +241,139 @@ static unsigned short get_display_hour(unsigned short hour) {
     return display_hour ? display_hour : 12;
 }
 
+#ifdef DIGIT_FB_BLIT
+#ifdef PBL_BW
+// 1-bit frame buffer, leftmost pixel in the lowest bit: 32 glyph pixels
+// are moved per step with a shift and merged into at most two words.
+// Inversion is a XOR of the source word.
+static void blit_glyph_row(const GBitmapDataRowInfo *row, int dst_x, const uint8_t *src, int width, uint32_t xor_mask) {
+    for (int sx = 0; sx < width; sx += 32) {
+        uint32_t bits;
+        memcpy(&bits, src + sx / 8, sizeof(bits));
+        bits ^= xor_mask;
+
+        int count = width - sx;
+        uint32_t mask = count >= 32 ? 0xFFFFFFFF : ((1u << count) - 1);
+        int dx = dst_x + sx;
+        uint8_t *dst = row->data + (dx >> 5) * 4;
+        int shift = dx & 31;
+
+        uint32_t word;
+        memcpy(&word, dst, sizeof(word));
+        word = (word & ~(mask << shift)) | ((bits & mask) << shift);
+        memcpy(dst, &word, sizeof(word));
+
+        if (shift && (mask >> (32 - shift))) {
+            memcpy(&word, dst + 4, sizeof(word));
+            word = (word & ~(mask >> (32 - shift))) | ((bits & mask) >> (32 - shift));
+            memcpy(dst + 4, &word, sizeof(word));
+        }
+    }
+}
+#else
+// Palettized glyphs keep the leftmost pixel in the highest bit: the
+// nibble's top bit maps to the first (lowest address) byte of the word.
+static const uint32_t nibble_bytes[16] = {
+    0x00000000, 0xFF000000, 0x00FF0000, 0xFFFF0000,
+    0x0000FF00, 0xFF00FF00, 0x00FFFF00, 0xFFFFFF00,
+    0x000000FF, 0xFF0000FF, 0x00FF00FF, 0xFFFF00FF,
+    0x0000FFFF, 0xFF00FFFF, 0x00FFFFFF, 0xFFFFFFFF,
+};
+
+// 8-bit frame buffer: the glyph paper is transparent, so only ink pixels
+// are written, four at a time through a byte mask. Rows of the round
+// display only hold pixels between min_x and max_x.
+static void blit_glyph_row(const GBitmapDataRowInfo *row, int dst_x, const uint8_t *src, int width, uint32_t xor_mask) {
+    uint32_t fill = foreground_color.argb * 0x01010101u;
+
+    for (int sx = 0; sx < width; sx += 8) {
+        uint8_t ink = src[sx / 8] ^ (uint8_t)xor_mask;
+        if (!ink) {
+            continue;
+        }
+
+        for (int px = sx; px < sx + 8 && px < width; px += 4) {
+            int x = dst_x + px;
+            int count = width - px < 4 ? width - px : 4;
+            uint32_t bits = px == sx ? ink >> 4 : ink & 0xF;
+            if (!bits) {
+                continue;
+            }
+
+            if (count == 4 && x >= row->min_x && x + 3 <= row->max_x) {
+                uint32_t mask = nibble_bytes[bits];
+                uint32_t word;
+                memcpy(&word, row->data + x, sizeof(word));
+                word = (word & ~mask) | (fill & mask);
+                memcpy(row->data + x, &word, sizeof(word));
+            } else {
+                for (int i = 0; i < count; i++) {
+                    if ((bits & (8 >> i)) && x + i >= row->min_x && x + i <= row->max_x) {
+                        row->data[x + i] = foreground_color.argb;
+                    }
+                }
+            }
+        }
+    }
+}
+#endif
+
+static void blit_glyph(GBitmap *frame_buffer, int slot_number) {
+    GBitmap *glyph = digit_images[slot_number];
+    if (!glyph || image_slot_state[slot_number] == EMPTY_SLOT) {
+        return;
+    }
+
+    Layer *slot_layer = bitmap_layer_get_layer(digit_layers[slot_number]);
+    GRect frame = layer_get_frame(slot_layer);
+    GRect bounds = layer_get_bounds(slot_layer);
+    GRect glyph_bounds = gbitmap_get_bounds(glyph);
+    int screen_h = gbitmap_get_bounds(frame_buffer).size.h;
+
+    #ifdef PBL_BW
+    // glyphs are black on white, the normal style shows them inverted
+    uint32_t xor_mask = compositing_mode == GCompOpAssignInverted ? 0xFFFFFFFF : 0;
+    #else
+    // palette index 1 is the ink unless the theme put it at index 0
+    uint32_t xor_mask = gbitmap_get_palette(glyph)[1].a ? 0 : 0xFFFFFFFF;
+    #endif
+
+    const uint8_t *src = gbitmap_get_data(glyph);
+    uint16_t src_stride = gbitmap_get_bytes_per_row(glyph);
+    int width = glyph_bounds.size.w < frame.size.w ? glyph_bounds.size.w : frame.size.w;
+
+    for (int y = 0; y < glyph_bounds.size.h; y++) {
+        int screen_y = frame.origin.y + bounds.origin.y + y;
+        if (screen_y < frame.origin.y || screen_y >= frame.origin.y + frame.size.h
+                || screen_y < 0 || screen_y >= screen_h) {
+            continue;
+        }
+        GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame_buffer, screen_y);
+        blit_glyph_row(&row, frame.origin.x, src + y * src_stride, width, xor_mask);
+    }
+}
+
+static void digits_layer_update_callback(Layer *layer, GContext* ctx) {
+    GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+    if (!frame_buffer) {
+        return;
+    }
+    for (int i = 0; i < TOTAL_IMAGE_SLOTS; i++) {
+        blit_glyph(frame_buffer, i);
+    }
+    graphics_release_frame_buffer(ctx, frame_buffer);
+}
+#endif
+
 static void line_layer_update_callback(Layer *layer, GContext* ctx) {
+    GRect bounds = layer_get_bounds(layer);
     graphics_context_set_fill_color(ctx, foreground_color);
-    graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
+    graphics_fill_rect(ctx, bounds, 0, GCornerNone);
 }
 
-static void layer_set_y(Layer *layer, int y) {
+static void layer_set_y(Layer *layer, LayoutId id, int shift) {
     GRect frame = layer_get_frame(layer);
-    frame.origin.y = y;
+    frame.origin.y = LAYOUT_RECTS[id].origin.y + shift;
     layer_set_frame(layer, frame);
 }
 
@@ -117,20 +385,25 @@ void simplebig_update_bounds(void) {
     // Get the total available screen real-estate
     GRect bounds = layer_get_unobstructed_bounds(main_window_layer);
 
-    int time_display_top = bounds.size.h - DIGIT_IMAGE_HEIGHT;
+    // The time sits at the bottom, move it up with the obstruction
+    int shift = bounds.size.h - full_bounds.size.h;
     for (int i = 0; i < 4; i++) {
-        layer_set_y(bitmap_layer_get_layer(digit_layers[i]), time_display_top);
+        layer_set_y(bitmap_layer_get_layer(digit_layers[i]), DIGIT_LAYOUT_IDS[i], shift);
     }
-    layer_set_y(bitmap_layer_get_layer(layer_sep_img), time_display_top);
-    layer_set_y(layer_line, time_display_top);
+    layer_set_y(bitmap_layer_get_layer(layer_sep_img), LAYOUT_BIG_SEP, shift);
+    layer_set_y(layer_line, LAYOUT_BIG_LINE, shift);
 
     // Hide the date if screen is obstructed
     bool hide_date = !grect_equal(&full_bounds, &bounds);
-    layer_set_hidden(text_layer_get_layer(layer_date_text), hide_date);
+    layer_set_hidden(layer_date_text, hide_date);
     layer_set_hidden(layer_line, hide_date);
     #endif
 }
 
+void simplebig_invalidate_cache(void) {
+    text_cache_layer_invalidate(layer_date_text);
+}
+
 void simplebig_update_time(struct tm *tick_time) {
     // Need to be static because they're used by the system later.
     static char date_text[] = "Xxxxxxxxx\nXxxxxxxxx 00";
@@ -141,18 +414,35 @@ void simplebig_update_time(struct tm *tick_time) {
         cur_day = new_cur_day;
 
         strftime(date_text, sizeof(date_text), PBL_IF_ROUND_ELSE("%a, %b %e", "%A\n%B %e"), tick_time);
-        text_layer_set_text(layer_date_text, date_text);
+        text_cache_layer_set_text(layer_date_text, date_text);
     }
 
+    #ifdef DIGIT_ANIMATION
+    stop_digit_animation();
+    #endif
+
     display_time_value(get_display_hour(tick_time->tm_hour), 0, clock_is_24h_style());
     display_time_value(tick_time->tm_min, 1, true);
+
+    #ifdef DIGIT_ANIMATION
+    start_digit_animation();
+    #endif
 }
 
 void simplebig_set_style(bool inverse) {
-    foreground_color  = inverse ? GColorBlack : GColorWhite;
+    foreground_color  = theme_foreground(inverse);
+    #ifdef PBL_COLOR
+    // themed through the glyph palettes, drawn with a transparent paper
+    compositing_mode  = GCompOpSet;
+    theme_recolor(img_dig_separator, foreground_color);
+    for (int i = 0; i < 4; i++) {
+        theme_recolor(digit_images[i], foreground_color);
+    }
+    #else
     compositing_mode  = inverse ? GCompOpAssign : GCompOpAssignInverted;
+    #endif
 
-    text_layer_set_text_color(layer_date_text, foreground_color);
+    text_cache_layer_set_text_color(layer_date_text, foreground_color);
     bitmap_layer_set_compositing_mode(layer_sep_img, compositing_mode);
     for (int i = 0; i < 4; i++) {
         bitmap_layer_set_compositing_mode(digit_layers[i], compositing_mode);
@@ -164,60 +454,30 @@ void simplebig_init(Window* window) {
     main_window_layer = window_get_root_layer(window);
     foreground_color = GColorBlack;
 
-    // Get the total available screen real-estate
-    GRect bounds = layer_get_bounds(main_window_layer);
-
-    int padding = (bounds.size.w - LAYOUT_WIDTH) / 2;
-    int time_display_top = PBL_IF_ROUND_ELSE((bounds.size.h - DIGIT_IMAGE_HEIGHT)/2, bounds.size.h - DIGIT_IMAGE_HEIGHT);
-    int time_display_bott = time_display_top + DIGIT_IMAGE_HEIGHT;
-    int date_display_top = PBL_IF_ROUND_ELSE(time_display_bott + 2, time_display_top - 1 - 2 * DATE_FONT_LINE_HEIGHT);
-
     // resources
     img_dig_separator  = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_NUM_SEP);
 
     // layers
-    layer_date_text = text_layer_create(GRect(
-        5,
-        date_display_top,
-        bounds.size.w-10,
-        PBL_IF_ROUND_ELSE(DATE_FONT_LINE_HEIGHT, 2 * DATE_FONT_LINE_HEIGHT)
-    ));
-
-    text_layer_set_text_alignment(layer_date_text, GTextAlignmentCenter);
-
-    layer_sep_img   = bitmap_layer_create(GRect(
-        padding + DIGIT_IMAGE_WIDTH*2,
-        time_display_top,
-        8,
-        DIGIT_IMAGE_HEIGHT
-    ));
-    layer_line      = layer_create(GRect(
-        padding + 8,
-        time_display_top,
-        LAYOUT_WIDTH - 16,
-        2
-    ));
+    layer_date_text = text_cache_layer_create(LAYOUT_RECTS[LAYOUT_BIG_DATE]);
+
+    text_cache_layer_set_text_alignment(layer_date_text, GTextAlignmentCenter);
+
+    layer_sep_img   = bitmap_layer_create(LAYOUT_RECTS[LAYOUT_BIG_SEP]);
+    layer_line      = layer_create(LAYOUT_RECTS[LAYOUT_BIG_LINE]);
     #ifdef PBL_ROUND
-    layer_line_bott      = layer_create(GRect(
-        padding + 8,
-        time_display_bott - 2,
-        LAYOUT_WIDTH - 16,
-        2
-    ));
+    layer_line_bott = layer_create(LAYOUT_RECTS[LAYOUT_BIG_LINE_BOTT]);
     #endif
 
     // time layers
     for (int i = 0; i < 4; i++) {
-        digit_layers[i] = bitmap_layer_create(GRect(
-            padding + (i % 2) * DIGIT_IMAGE_WIDTH + (i / 2) * (LAYOUT_WIDTH-DIGIT_IMAGE_WIDTH*2),
-            time_display_top,
-            DIGIT_IMAGE_WIDTH,
-            DIGIT_IMAGE_HEIGHT
-        ));
+        digit_layers[i] = bitmap_layer_create(LAYOUT_RECTS[DIGIT_LAYOUT_IDS[i]]);
     }
+    #ifdef DIGIT_FB_BLIT
+    layer_digits = layer_create(layer_get_bounds(main_window_layer));
+    layer_set_update_proc(layer_digits, digits_layer_update_callback);
+    #endif
 
-    text_layer_set_background_color(layer_date_text, GColorClear);
-    text_layer_set_font(layer_date_text, fonts_get_system_font(DATE_FONT_KEY));
+    text_cache_layer_set_font(layer_date_text, fonts_get_system_font(DATE_FONT_KEY));
 
     bitmap_layer_set_bitmap(layer_sep_img,  img_dig_separator);
 
@@ -227,23 +487,26 @@ void simplebig_init(Window* window) {
     #endif
 
     // composing layers
-    layer_add_child(main_window_layer, text_layer_get_layer(layer_date_text));
+    layer_add_child(main_window_layer, layer_date_text);
     for (int i = 0; i < 4; i++) {
         layer_add_child(main_window_layer, bitmap_layer_get_layer(digit_layers[i]));
     }
+    #ifdef DIGIT_FB_BLIT
+    layer_add_child(main_window_layer, layer_digits);
+    #endif
     layer_add_child(main_window_layer, bitmap_layer_get_layer(layer_sep_img));
     layer_add_child(main_window_layer, layer_line);
     #ifdef PBL_ROUND
     layer_add_child(main_window_layer, layer_line_bott);
     #endif
-
-    for (int i = 0; i < 4; i++) {
-        load_digit_image_into_slot(i, 0);
-    }
 }
 
 void simplebig_deinit(void) {
-    text_layer_destroy(layer_date_text);
+    #ifdef DIGIT_ANIMATION
+    stop_digit_animation();
+    #endif
+
+    text_cache_layer_destroy(layer_date_text);
     bitmap_layer_destroy(layer_sep_img);
     gbitmap_destroy(img_dig_separator);
     layer_destroy(layer_line);
@@ -251,6 +514,9 @@ void simplebig_deinit(void) {
     layer_destroy(layer_line_bott);
     #endif
 
+    #ifdef DIGIT_FB_BLIT
+    layer_destroy(layer_digits);
+    #endif
     for (int i = 0; i < 4; i++) {
         bitmap_layer_destroy(digit_layers[i]);
         if (digit_images[i]) {
@@ -6,5 +6,7 @@ void simplebig_deinit(void);
 void simplebig_set_style(bool inverse);
 void simplebig_update_time(struct tm *tick_time);
 void simplebig_update_bounds(void);
+// Drops cached pixels that captured what is drawn below the face.
+void simplebig_invalidate_cache(void);
 
 #endif /* SIMPLEBIG_H */
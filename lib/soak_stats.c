@@ -0,0 +1,60 @@
+#include "pebble.h"
+#include "soak_stats.h"
+
+#ifdef SOAK_STATS
+
+// Totals since launch, logged every hour of watch time and on exit as
+// one line that buildtools/soak.py reduces into its report.
+static uint32_t wakeups = 0;
+static uint32_t redraws = 0;
+static uint32_t heap_peak = 0;
+static uint32_t message_in_bytes = 0;
+static uint32_t message_out_bytes = 0;
+static uint32_t persist_writes = 0;
+static uint32_t persist_bytes = 0;
+
+static void sample_heap(void) {
+    uint32_t used = heap_bytes_used();
+    if (used > heap_peak) {
+        heap_peak = used;
+    }
+}
+
+void soak_stats_tick(struct tm *tick_time) {
+    soak_stats_wakeup();
+    if (tick_time->tm_min == 0) {
+        soak_stats_report();
+    }
+}
+
+void soak_stats_wakeup(void) {
+    wakeups++;
+    sample_heap();
+}
+
+void soak_stats_redraw(void) {
+    redraws++;
+    sample_heap();
+}
+
+void soak_stats_message(DictionaryIterator *iterator, bool outgoing) {
+    uint32_t size = dict_size(iterator);
+    if (outgoing) {
+        message_out_bytes += size;
+    } else {
+        message_in_bytes += size;
+    }
+}
+
+void soak_stats_persist(size_t bytes) {
+    persist_writes++;
+    persist_bytes += bytes;
+}
+
+void soak_stats_report(void) {
+    APP_LOG(APP_LOG_LEVEL_INFO, "soak: wakeups %d redraws %d heap %d peak %d in %d out %d persist %d %d",
+            (int)wakeups, (int)redraws, (int)heap_bytes_used(), (int)heap_peak,
+            (int)message_in_bytes, (int)message_out_bytes, (int)persist_writes, (int)persist_bytes);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SOAK_STATS_H
+#define SOAK_STATS_H
+
+// Counters for long emulator runs, enabled with `--soak-stats` at
+// configure time (see buildtools/instrument.py and buildtools/soak.py).
+// Compiles to nothing otherwise. Include it after pebble.h in every file
+// that writes to persistent storage, so the writes are counted.
+#ifdef SOAK_STATS
+void soak_stats_tick(struct tm *tick_time);
+void soak_stats_wakeup(void);
+void soak_stats_redraw(void);
+void soak_stats_message(DictionaryIterator *iterator, bool outgoing);
+void soak_stats_persist(size_t bytes);
+void soak_stats_report(void);
+
+#define persist_write_bool(key, value) \
+    (soak_stats_persist(sizeof(bool)), persist_write_bool(key, value))
+#define persist_write_int(key, value) \
+    (soak_stats_persist(sizeof(int32_t)), persist_write_int(key, value))
+#define persist_write_data(key, data, size) \
+    (soak_stats_persist(size), persist_write_data(key, data, size))
+#define persist_write_string(key, cstring) \
+    (soak_stats_persist(strlen(cstring) + 1), persist_write_string(key, cstring))
+#else
+#define soak_stats_tick(tick_time)
+#define soak_stats_wakeup()
+#define soak_stats_redraw()
+#define soak_stats_message(iterator, outgoing)
+#define soak_stats_persist(bytes)
+#define soak_stats_report()
+#endif
+
+#endif /* SOAK_STATS_H */
@@ -0,0 +1,219 @@
+#include "pebble.h"
+#include "vars.h"
+#include "render_stats.h"
+#include "soak_stats.h"
+#include "layout.auto.h"
+#include "solar.h"
+#include "theme.h"
+
+// Sunrise and sunset from the NOAA approximation, in fixed point only:
+// angles are Pebble trig angles (TRIG_MAX_ANGLE per turn), ratios are
+// TRIG_MAX_RATIO based and times are seconds. Computed once per day.
+
+#define NO_TIME -1
+// sun center 0.833 degrees below the horizon (refraction + radius)
+#define HORIZON_SIN -954
+
+typedef struct {
+    int32_t latitude;   // hundredths of a degree
+    int32_t longitude;
+} SolarLocation;
+
+static SolarLocation location;
+static bool location_known = false;
+
+static int cur_day = -1;
+static int sunrise_minute = NO_TIME;
+static int sunset_minute = NO_TIME;
+
+#ifdef PBL_ROUND
+static TextLayer *s_sun_layer;
+static char sun_layer_buffer[] = "00:00 - 00:00";
+#endif
+
+static int32_t centidegrees_to_angle(int32_t centidegrees) {
+    return centidegrees * TRIG_MAX_ANGLE / 36000;
+}
+
+static int32_t normalize_angle(int32_t angle) {
+    return ((angle % TRIG_MAX_ANGLE) + TRIG_MAX_ANGLE) % TRIG_MAX_ANGLE;
+}
+
+// acos over [0, half turn], cos_lookup being decreasing there
+static int32_t acos_angle(int32_t ratio) {
+    int32_t low = 0;
+    int32_t high = TRIG_MAX_ANGLE / 2;
+    while (low < high) {
+        int32_t middle = (low + high) / 2;
+        if (cos_lookup(middle) > ratio) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static int seconds_to_minute_of_day(int32_t seconds) {
+    return ((seconds % 86400) + 86400) % 86400 / 60;
+}
+
+static void compute_times(struct tm *tick_time) {
+    int day = tick_time->tm_yday + 1;
+
+    // solar declination
+    int32_t year_angle = normalize_angle((day + 10) * TRIG_MAX_ANGLE / 365);
+    int32_t declination = centidegrees_to_angle(-2344 * cos_lookup(year_angle) / TRIG_MAX_RATIO);
+
+    // equation of time, in seconds
+    int32_t b = normalize_angle((day - 81) * TRIG_MAX_ANGLE / 364);
+    int32_t eot = (592 * sin_lookup(normalize_angle(2 * b))
+                   - 452 * cos_lookup(b)
+                   - 90 * sin_lookup(b)) / TRIG_MAX_RATIO;
+
+    // hour angle of sunrise: cos w = (sin h0 - sin lat sin d) / (cos lat cos d)
+    int32_t latitude = normalize_angle(centidegrees_to_angle(location.latitude));
+    int64_t numerator = (int64_t)HORIZON_SIN * TRIG_MAX_RATIO
+                        - (int64_t)sin_lookup(latitude) * sin_lookup(declination);
+    int64_t denominator = (int64_t)cos_lookup(latitude) * cos_lookup(declination);
+    if (denominator == 0) {
+        sunrise_minute = sunset_minute = NO_TIME;
+        return;
+    }
+
+    int64_t cos_hour_angle = numerator * TRIG_MAX_RATIO / denominator;
+    if (cos_hour_angle >= TRIG_MAX_RATIO || cos_hour_angle <= -TRIG_MAX_RATIO) {
+        // polar night or midnight sun
+        sunrise_minute = sunset_minute = NO_TIME;
+        return;
+    }
+
+    int32_t hour_angle = acos_angle((int32_t)cos_hour_angle);
+    // days longer than ~18 h overflow the product in 32 bits
+    int32_t half_day = (int32_t)((int64_t)hour_angle * 86400 / TRIG_MAX_ANGLE);
+    int32_t noon = 43200 - location.longitude * 24 / 10 - eot + tick_time->tm_gmtoff;
+
+    sunrise_minute = seconds_to_minute_of_day(noon - half_day);
+    sunset_minute = seconds_to_minute_of_day(noon + half_day);
+}
+
+#ifdef PBL_ROUND
+static int format_minute(char *buffer, size_t size, int minute) {
+    int hour = minute / 60;
+    if (!clock_is_24h_style()) {
+        hour = hour % 12 ? hour % 12 : 12;
+    }
+    return snprintf(buffer, size, "%d:%02d", hour, minute % 60);
+}
+
+static void update_sun_layer(void) {
+    if (sunrise_minute == NO_TIME) {
+        layer_set_hidden(text_layer_get_layer(s_sun_layer), true);
+        return;
+    }
+
+    int length = format_minute(sun_layer_buffer, sizeof(sun_layer_buffer), sunrise_minute);
+    length += snprintf(sun_layer_buffer + length, sizeof(sun_layer_buffer) - length, " - ");
+    format_minute(sun_layer_buffer + length, sizeof(sun_layer_buffer) - length, sunset_minute);
+
+    text_layer_set_text(s_sun_layer, sun_layer_buffer);
+    layer_set_hidden(text_layer_get_layer(s_sun_layer), false);
+}
+#endif
+
+static void update_day(struct tm *tick_time, bool force) {
+    // Only recompute when the day (or the location) has changed.
+    int new_cur_day = tick_time->tm_year*1000 + tick_time->tm_yday;
+    if (!location_known || (new_cur_day == cur_day && !force)) {
+        return;
+    }
+    cur_day = new_cur_day;
+
+    compute_times(tick_time);
+    #ifdef PBL_ROUND
+    update_sun_layer();
+    #endif
+}
+
+// public methods
+void solar_inbox_received(DictionaryIterator *iterator, void *context) {
+    Tuple *latitude_t = dict_find(iterator, MESSAGE_KEY_LATITUDE);
+    Tuple *longitude_t = dict_find(iterator, MESSAGE_KEY_LONGITUDE);
+    if (!latitude_t || !longitude_t) {
+        return;
+    }
+
+    SolarLocation new_location = {
+        .latitude = latitude_t->value->int32,
+        .longitude = longitude_t->value->int32,
+    };
+    if (location_known && new_location.latitude == location.latitude
+            && new_location.longitude == location.longitude) {
+        return;
+    }
+
+    location = new_location;
+    location_known = true;
+    persist_write_data(LOCATION_KEY, &location, sizeof(location));
+
+    time_t now = time(NULL);
+    update_day(localtime(&now), true);
+}
+
+bool solar_get_times(int *sunrise, int *sunset) {
+    if (sunrise_minute == NO_TIME) {
+        return false;
+    }
+    *sunrise = sunrise_minute;
+    *sunset = sunset_minute;
+    return true;
+}
+
+bool solar_is_day(struct tm *tick_time, bool *is_day) {
+    if (sunrise_minute == NO_TIME) {
+        return false;
+    }
+    int minute = tick_time->tm_hour * 60 + tick_time->tm_min;
+    if (sunrise_minute < sunset_minute) {
+        *is_day = minute >= sunrise_minute && minute < sunset_minute;
+    } else {
+        *is_day = minute >= sunrise_minute || minute < sunset_minute;
+    }
+    return true;
+}
+
+void solar_set_style(bool inverse) {
+    #ifdef PBL_ROUND
+    text_layer_set_text_color(s_sun_layer, theme_foreground(inverse));
+    #endif
+}
+
+void solar_update_time(struct tm *tick_time) {
+    update_day(tick_time, false);
+}
+
+void solar_init(Window* window) {
+    #ifdef PBL_ROUND
+    Layer *window_layer = window_get_root_layer(window);
+
+    // below the date, where the bezel is still wide enough
+    s_sun_layer = text_layer_create(LAYOUT_RECTS[LAYOUT_SOLAR_SUN]);
+    text_layer_set_background_color(s_sun_layer, GColorClear);
+    text_layer_set_text_alignment(s_sun_layer, GTextAlignmentCenter);
+    text_layer_set_font(s_sun_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+    layer_set_hidden(text_layer_get_layer(s_sun_layer), true);
+    layer_add_child(window_layer, text_layer_get_layer(s_sun_layer));
+    #endif
+
+    location_known = persist_read_data(LOCATION_KEY, &location, sizeof(location)) == sizeof(location);
+
+    // known before the first style pass, for auto inverse
+    time_t now = time(NULL);
+    update_day(localtime(&now), true);
+}
+
+void solar_deinit(void) {
+    #ifdef PBL_ROUND
+    text_layer_destroy(s_sun_layer);
+    #endif
+}
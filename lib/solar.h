@@ -0,0 +1,12 @@
+#ifndef SOLAR_H
+#define SOLAR_H
+
+void solar_init(Window* window);
+void solar_deinit(void);
+void solar_set_style(bool inverse);
+void solar_update_time(struct tm *tick_time);
+void solar_inbox_received(DictionaryIterator *iterator, void *context);
+bool solar_is_day(struct tm *tick_time, bool *is_day);
+bool solar_get_times(int *sunrise, int *sunset);
+
+#endif /* SOLAR_H */
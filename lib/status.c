@@ -1,34 +1,74 @@
 #include "pebble.h"
 #include "vars.h"
+#include "render_stats.h"
+#include "soak_stats.h"
+#include "layout.auto.h"
 #include "status.h"
-
-#define BATT_IMAGE_SIZE 16
-#define CONN_IMAGE_SIZE 20
+#include "rings.h"
+#include "theme.h"
 
 static BitmapLayer *layer_batt_img;
 static BitmapLayer *layer_conn_img;
 
-static GBitmap *img_battery_full;
-static GBitmap *img_battery_half;
-static GBitmap *img_battery_low;
-static GBitmap *img_battery_charge;
-static GBitmap *img_bt_connect;
-static GBitmap *img_bt_disconnect;
+// Only the icons on screen are loaded, like the digits in simplebig.c.
+static GBitmap *img_battery;
+static GBitmap *img_conn;
+static uint32_t img_battery_id = 0;
+static uint32_t img_conn_id = 0;
 
 static TextLayer *layer_batt_text;
 static int charge_percent = 0;
 
+// Last shown state, for the glance
+static BatteryChargeState battery_state;
+static bool bluetooth_connected;
+
 static const uint32_t const segments[] = { 300, 100, 300, 100, 300 };
 static VibePattern panicPattern = {
   .durations = segments,
   .num_segments = ARRAY_LENGTH(segments),
 };
 
+static void recolor_icon(GBitmap *image, uint32_t resource_id) {
+    #ifdef PBL_COLOR
+    // "all good" icons follow the theme, warnings keep their colors
+    if (resource_id == RESOURCE_ID_IMAGE_BATTERY_FULL
+            || resource_id == RESOURCE_ID_IMAGE_BATTERY_CHARGE
+            || resource_id == RESOURCE_ID_IMAGE_CONNECT) {
+        theme_recolor(image, theme_accent());
+    }
+    #endif
+}
+
+static void load_icon(BitmapLayer *layer, GBitmap **image, uint32_t *image_id, uint32_t resource_id) {
+    if (*image_id == resource_id) {
+        return;
+    }
+
+    GBitmap *old_image = *image;
+    *image = gbitmap_create_with_resource(resource_id);
+    recolor_icon(*image, resource_id);
+    bitmap_layer_set_bitmap(layer, *image);
+    if (old_image) {
+        gbitmap_destroy(old_image);
+    }
+    *image_id = resource_id;
+}
+
 static void handle_battery(BatteryChargeState charge_state) {
+    soak_stats_wakeup();
+
+    battery_state = charge_state;
+    charge_percent = charge_state.charge_percent;
+
+    #ifdef PBL_ROUND
+    // drawn as the outer bezel ring instead of the corner icon
+    rings_set_battery(charge_state);
+    #else
     static char battery_text[] = "100 ";
 
     if (charge_state.is_charging) {
-        bitmap_layer_set_bitmap(layer_batt_img, img_battery_charge);
+        load_icon(layer_batt_img, &img_battery, &img_battery_id, RESOURCE_ID_IMAGE_BATTERY_CHARGE);
 
         snprintf(battery_text, sizeof(battery_text), "+%d", charge_state.charge_percent);
         #ifdef PBL_COLOR
@@ -37,36 +77,35 @@ static void handle_battery(BatteryChargeState charge_state) {
     } else {
         snprintf(battery_text, sizeof(battery_text), "%d", charge_state.charge_percent);
         if (charge_state.charge_percent <= 20) {
-            bitmap_layer_set_bitmap(layer_batt_img, img_battery_low);
+            load_icon(layer_batt_img, &img_battery, &img_battery_id, RESOURCE_ID_IMAGE_BATTERY_LOW);
             #ifdef PBL_COLOR
             text_layer_set_text_color(layer_batt_text, GColorRed);
             #endif
         } else if (charge_state.charge_percent <= 50) {
-            bitmap_layer_set_bitmap(layer_batt_img, img_battery_half);
+            load_icon(layer_batt_img, &img_battery, &img_battery_id, RESOURCE_ID_IMAGE_BATTERY_HALF);
             #ifdef PBL_COLOR
             text_layer_set_text_color(layer_batt_text, GColorYellow);
             #endif
         } else {
-            bitmap_layer_set_bitmap(layer_batt_img, img_battery_full);
+            load_icon(layer_batt_img, &img_battery, &img_battery_id, RESOURCE_ID_IMAGE_BATTERY_FULL);
             #ifdef PBL_COLOR
             text_layer_set_text_color(layer_batt_text, GColorGreen);
             #endif
         }
     }
-    charge_percent = charge_state.charge_percent;
-    
+
     text_layer_set_text(layer_batt_text, battery_text);
+    #endif
 }
 
 static void update_bluetooth(bool connected) {
-    if (connected) {
-        bitmap_layer_set_bitmap(layer_conn_img, img_bt_connect);
-    } else {
-        bitmap_layer_set_bitmap(layer_conn_img, img_bt_disconnect);
-    }
+    bluetooth_connected = connected;
+    load_icon(layer_conn_img, &img_conn, &img_conn_id,
+              connected ? RESOURCE_ID_IMAGE_CONNECT : RESOURCE_ID_IMAGE_DISCONNECT);
 }
 
 static void handle_bluetooth(bool connected) {
+    soak_stats_wakeup();
     update_bluetooth(connected);
     
     if (!connected) {
@@ -86,8 +125,11 @@ static void handle_appfocus(bool in_focus){
 void status_set_style(bool inverse) {
     #ifdef PBL_COLOR
     GCompOp compositing_mode = GCompOpSet;
+
+    recolor_icon(img_battery, img_battery_id);
+    recolor_icon(img_conn, img_conn_id);
     #else
-    text_layer_set_text_color(layer_batt_text, inverse ? GColorBlack : GColorWhite);
+    text_layer_set_text_color(layer_batt_text, theme_foreground(inverse));
 
     GCompOp compositing_mode = inverse ? GCompOpAssign : GCompOpAssignInverted;
     #endif
@@ -96,6 +138,15 @@ void status_set_style(bool inverse) {
     bitmap_layer_set_compositing_mode(layer_conn_img, compositing_mode);
 }
 
+int status_glance_text(char *buffer, size_t size) {
+    // short lines, see LAYOUT_GLANCE; "+" is charging, as on the face
+    snprintf(buffer, size, "Battery %s%d%%\nBluetooth %s\n",
+             battery_state.is_charging ? "+" : "",
+             battery_state.charge_percent,
+             bluetooth_connected ? "on" : "off");
+    return strlen(buffer);
+}
+
 void status_update(void) {
     handle_battery(battery_state_service_peek());
     update_bluetooth(bluetooth_connection_service_peek());
@@ -103,30 +154,22 @@ void status_update(void) {
 
 void status_init(Window* window) {
     Layer *window_layer = window_get_root_layer(window);
-    // Get the total available screen real-estate
-    GRect bounds = layer_get_bounds(window_layer);
-    int padding_v = PBL_IF_ROUND_ELSE(18, 10);
-    int padding_h = PBL_IF_ROUND_ELSE(STATUS_ROUND_PADDING_H, 6);
-
-    // resources
-    img_bt_connect     = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_CONNECT);
-    img_bt_disconnect  = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_DISCONNECT);
-    img_battery_full   = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BATTERY_FULL);
-    img_battery_half   = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BATTERY_HALF);
-    img_battery_low    = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BATTERY_LOW);
-    img_battery_charge = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BATTERY_CHARGE);
 
     // layers
-    layer_batt_text = text_layer_create(GRect(padding_h - 3, padding_v + 10, BATT_IMAGE_SIZE + 14, 20));
-    layer_batt_img  = bitmap_layer_create(GRect(padding_h + 4, padding_v, BATT_IMAGE_SIZE, BATT_IMAGE_SIZE));
-    layer_conn_img  = bitmap_layer_create(GRect(bounds.size.w - CONN_IMAGE_SIZE - padding_h, padding_v + 2, CONN_IMAGE_SIZE, CONN_IMAGE_SIZE));
+    layer_batt_text = text_layer_create(LAYOUT_RECTS[LAYOUT_STATUS_BATT_TEXT]);
+    layer_batt_img  = bitmap_layer_create(LAYOUT_RECTS[LAYOUT_STATUS_BATT_IMG]);
+    layer_conn_img  = bitmap_layer_create(LAYOUT_RECTS[LAYOUT_STATUS_CONN_IMG]);
 
     text_layer_set_background_color(layer_batt_text, GColorClear);
     text_layer_set_font(layer_batt_text, fonts_get_system_font(FONT_KEY_GOTHIC_14));
     text_layer_set_text_alignment(layer_batt_text, GTextAlignmentCenter);
 
-    bitmap_layer_set_bitmap(layer_batt_img, img_battery_full);
-    bitmap_layer_set_bitmap(layer_conn_img, img_bt_connect);
+    #ifdef PBL_ROUND
+    layer_set_hidden(bitmap_layer_get_layer(layer_batt_img), true);
+    layer_set_hidden(text_layer_get_layer(layer_batt_text), true);
+    #endif
+
+    status_update();
 
     // composing layers
     layer_add_child(window_layer, bitmap_layer_get_layer(layer_batt_img));
@@ -148,10 +191,6 @@ void status_deinit(void) {
     bitmap_layer_destroy(layer_batt_img);
     bitmap_layer_destroy(layer_conn_img);
 
-    gbitmap_destroy(img_bt_connect);
-    gbitmap_destroy(img_bt_disconnect);
-    gbitmap_destroy(img_battery_full);
-    gbitmap_destroy(img_battery_half);
-    gbitmap_destroy(img_battery_low);
-    gbitmap_destroy(img_battery_charge);
+    gbitmap_destroy(img_battery);
+    gbitmap_destroy(img_conn);
 }
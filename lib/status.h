@@ -5,5 +5,6 @@ void status_init(Window* window);
 void status_deinit(void);
 void status_set_style(bool inverse);
 void status_update(void);
+int status_glance_text(char *buffer, size_t size);
 
 #endif /* STATUS_H */
@@ -0,0 +1,40 @@
+const termoClayConfig = {
+    "type": "section",
+    "items": [
+        {
+            "type": "heading",
+            "defaultValue": "Weather"
+        },
+        {
+            "type": "input",
+            "messageKey": "CITY",
+            "label": "City",
+            "description": "City name as used by termopogoda.ru",
+            "defaultValue": "tomsk"
+        },
+        {
+            "type": "toggle",
+            "messageKey": "CITY_AUTO",
+            "label": "Detect city by location",
+            "defaultValue": false
+        },
+        {
+            "type": "toggle",
+            "messageKey": "PUSH_MODE",
+            "label": "Phone pushes the weather",
+            "description": "The phone refreshes the weather by itself and only sends changes, so the watch never asks for it",
+            // off until the pull and push soaks of buildtools/soak.py
+            // have been compared
+            "defaultValue": false
+        },
+        {
+            "type": "toggle",
+            "messageKey": "AUTO_INVERSE",
+            "label": "Light face from sunrise to sunset",
+            "description": "Overrides the inverse setting once the location is known",
+            "defaultValue": false
+        }
+    ]
+};
+
+module.exports = termoClayConfig;
@@ -1,20 +1,107 @@
 #include "pebble.h"
 #include "vars.h"
+#include "render_stats.h"
+#include "soak_stats.h"
+#include "layout.auto.h"
 #include "termo.h"
+#include "theme.h"
 
 #define MAX_AGE 3600
+#define REFRESH_MINUTES 15
+// Pushed weather older than the phone's 30 minute heartbeat plus a
+// margin means the phone stopped pushing, the watch then asks itself.
+#define PUSH_STALE_AGE (40 * 60)
 
 static TextLayer *s_weather_layer;
 static GFont s_weather_font;
 static int termo_timestamp = 0;
+// In push mode the phone keeps the weather fresh on its own schedule
+// (see lib/termo.js) and the watch only asks when it went stale.
+static bool push_mode = false;
+static time_t pull_timestamp = 0;
 
-static char weather_layer_buffer[] = "-18.50C";
+static char weather_layer_buffer[TERMO_TEXT_SIZE] = "-18.50C";
+
+// Condition icons, all in the WEATHER_ICONS raw resource (see
+// fonttools/weather_icons.py). Only the current one is loaded, straight
+// into the data of a single bitmap, and only when the condition changes.
+#define CONDITION_NONE 0
+#define MAX_CONDITIONS 16
+
+typedef struct {
+    uint8_t count;
+    uint8_t width;
+    uint8_t height;
+    uint8_t row_size;
+    uint16_t offsets[MAX_CONDITIONS];
+} WeatherIconsHeader;
+
+static WeatherIconsHeader icons_header;
+static ResHandle icons_handle;
+static GBitmap *s_icon;
+static BitmapLayer *s_icon_layer;
+static int icon_condition = CONDITION_NONE;
+#ifdef PBL_COLOR
+static GColor icon_palette[2];
+#endif
+
+static void set_condition(int condition) {
+    if (condition < CONDITION_NONE || condition > icons_header.count || !s_icon) {
+        condition = CONDITION_NONE;
+    }
+    if (condition == icon_condition) {
+        return;
+    }
+    icon_condition = condition;
+
+    if (condition != CONDITION_NONE) {
+        resource_load_byte_range(icons_handle, icons_header.offsets[condition - 1],
+                                 gbitmap_get_data(s_icon), icons_header.row_size * icons_header.height);
+        layer_mark_dirty(bitmap_layer_get_layer(s_icon_layer));
+    }
+
+    bool with_icon = condition != CONDITION_NONE;
+    layer_set_hidden(bitmap_layer_get_layer(s_icon_layer), !with_icon);
+    layer_set_frame(text_layer_get_layer(s_weather_layer),
+                    LAYOUT_RECTS[with_icon ? LAYOUT_TERMO_WEATHER_WITH_ICON : LAYOUT_TERMO_WEATHER]);
+}
+
+static void load_icons(void) {
+    icons_handle = resource_get_handle(RESOURCE_ID_WEATHER_ICONS);
+    size_t header_size = resource_load_byte_range(icons_handle, 0, (uint8_t *)&icons_header, sizeof(icons_header));
+    if (header_size < offsetof(WeatherIconsHeader, offsets) || icons_header.count > MAX_CONDITIONS) {
+        icons_header.count = 0;
+        return;
+    }
+
+    s_icon = gbitmap_create_blank(GSize(icons_header.width, icons_header.height),
+                                  PBL_IF_COLOR_ELSE(GBitmapFormat1BitPalette, GBitmapFormat1Bit));
+    if (s_icon && gbitmap_get_bytes_per_row(s_icon) != icons_header.row_size) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Weather icons don't match the bitmap rows");
+        gbitmap_destroy(s_icon);
+        s_icon = NULL;
+    }
+    #ifdef PBL_COLOR
+    if (s_icon) {
+        icon_palette[0] = GColorClear;
+        icon_palette[1] = GColorBlack;
+        gbitmap_set_palette(s_icon, icon_palette, false);
+    }
+    #endif
+}
 
 void termo_inbox_received(DictionaryIterator *iterator, void *context) {
 
     // Look for item
     Tuple *t = dict_find(iterator, MESSAGE_KEY_TEMPERATURE);
+    Tuple *condition_t = dict_find(iterator, MESSAGE_KEY_CONDITION);
+    Tuple *push_t = dict_find(iterator, MESSAGE_KEY_PUSH_MODE);
  
+    if (push_t) {
+        push_mode = push_t->value->int32 == 1;
+        persist_write_bool(TERMO_PUSH_KEY, push_mode);
+    }
+
     // if there are some data
     if (t) {
         snprintf(weather_layer_buffer, sizeof(weather_layer_buffer), "%s", t->value->cstring);
@@ -24,25 +111,67 @@ void termo_inbox_received(DictionaryIterator *iterator, void *context) {
         // display
         text_layer_set_text(s_weather_layer, weather_layer_buffer);
     }
+
+    if (condition_t) {
+        persist_write_int(TERMO_CONDITION_KEY, condition_t->value->int32);
+        set_condition(condition_t->value->int32);
+    }
 }
 
 static void check_termo_age(void) {
     int age = time(NULL) - termo_timestamp;
     if (age > MAX_AGE) { // clear temperature
         text_layer_set_text(s_weather_layer, "...");
+        set_condition(CONDITION_NONE);
     }
 }
  
 // public methods
 void termo_set_style(bool inverse) {
-    GColor foreground_color  = inverse ? GColorBlack : GColorWhite;
+    GColor foreground_color  = theme_foreground(inverse);
     text_layer_set_text_color(s_weather_layer, foreground_color);
+
+    #ifdef PBL_COLOR
+    icon_palette[1] = foreground_color;
+    #else
+    bitmap_layer_set_compositing_mode(s_icon_layer, inverse ? GCompOpAssign : GCompOpAssignInverted);
+    #endif
+    layer_mark_dirty(bitmap_layer_get_layer(s_icon_layer));
+}
+
+int termo_glance_text(char *buffer, size_t size) {
+    time_t now = time(NULL);
+    int age = now - termo_timestamp;
+    int next = REFRESH_MINUTES - localtime(&now)->tm_min % REFRESH_MINUTES;
+
+    if (age > MAX_AGE) {
+        snprintf(buffer, size, "No weather\n");
+    } else {
+        snprintf(buffer, size, "Weather %dm old\n", age / 60);
+    }
+    // pushed weather comes whenever the phone has news
+    if (!push_mode) {
+        size_t length = strlen(buffer);
+        snprintf(buffer + length, size - length, "Next in %d min\n", next);
+    }
+    return strlen(buffer);
+}
+
+static bool wants_weather(void) {
+    if (!push_mode) {
+        return true;
+    }
+    time_t now = time(NULL);
+    // at most one request per stale period, until a push comes back
+    return now - termo_timestamp > PUSH_STALE_AGE && now - pull_timestamp > PUSH_STALE_AGE;
 }
 
 void termo_update_time(struct tm *tick_time) {
-    // Get weather update every 30 minutes
-    if (tick_time->tm_min % 15 == 0) {
-        if (bluetooth_connection_service_peek()) {
+    // Get weather update every 15 minutes
+    if (tick_time->tm_min % REFRESH_MINUTES == 0) {
+        if (wants_weather() && bluetooth_connection_service_peek()) {
+            pull_timestamp = time(NULL);
+
             // Begin dictionary
             DictionaryIterator *iter;
             app_message_outbox_begin(&iter);
@@ -51,6 +180,7 @@ void termo_update_time(struct tm *tick_time) {
             dict_write_uint8(iter, 0, 0);
 
             // Send the message!
+            soak_stats_message(iter, true);
             app_message_outbox_send();
         }
         
@@ -60,35 +190,45 @@ void termo_update_time(struct tm *tick_time) {
 
 void termo_init(Window* window) {
     Layer *window_layer = window_get_root_layer(window);
-    // Get the total available screen real-estate
-    GRect bounds = layer_get_bounds(window_layer);
-    int padding_v = PBL_IF_ROUND_ELSE(16, 8);
 
     // Create temperature Layer
-    s_weather_layer = text_layer_create(GRect(
-        (bounds.size.w - 80)/2,
-        PBL_IF_ROUND_ELSE(16, 8),
-        80,
-        23
-    ));
+    s_weather_layer = text_layer_create(LAYOUT_RECTS[LAYOUT_TERMO_WEATHER]);
     text_layer_set_background_color(s_weather_layer, GColorClear);
     text_layer_set_text_alignment(s_weather_layer, GTextAlignmentCenter);
     text_layer_set_text(s_weather_layer, "...");
+
+    // Create condition icon Layer, hidden until there is a condition
+    load_icons();
+    s_icon_layer = bitmap_layer_create(LAYOUT_RECTS[LAYOUT_TERMO_WEATHER_ICON]);
+    bitmap_layer_set_bitmap(s_icon_layer, s_icon);
+    #ifdef PBL_COLOR
+    bitmap_layer_set_compositing_mode(s_icon_layer, GCompOpSet);
+    #endif
+    layer_set_hidden(bitmap_layer_get_layer(s_icon_layer), true);
+
+    push_mode = persist_read_bool(TERMO_PUSH_KEY);
+
     if (persist_exists(TERMO_KEY)) {
         termo_timestamp = persist_read_int(TERMO_TS_KEY);
         int age = time(NULL) - termo_timestamp;
         if (age < MAX_AGE) { // restore only temp stored less than MAX_AGE
             persist_read_string(TERMO_KEY, weather_layer_buffer, sizeof(weather_layer_buffer));
             text_layer_set_text(s_weather_layer, weather_layer_buffer);
+            set_condition(persist_read_int(TERMO_CONDITION_KEY));
         }
     }
 
     text_layer_set_font(s_weather_layer, fonts_get_system_font(FONT_KEY_ROBOTO_CONDENSED_21));
     layer_add_child(window_layer, text_layer_get_layer(s_weather_layer));
+    layer_add_child(window_layer, bitmap_layer_get_layer(s_icon_layer));
 
 }
 
 void termo_deinit(void) {
     text_layer_destroy(s_weather_layer);
+    bitmap_layer_destroy(s_icon_layer);
+    if (s_icon) {
+        gbitmap_destroy(s_icon);
+    }
     app_message_deregister_callbacks();
 }
@@ -3,10 +3,14 @@
  
 #define KEY_TEMPERATURE 0
 
+// Longest TEMPERATURE text, terminator included, e.g. "-18.50C".
+#define TERMO_TEXT_SIZE 8
+
 void termo_init(Window* window);
 void termo_deinit(void);
 void termo_set_style(bool inverse);
 void termo_update_time(struct tm *tick_time);
 void termo_inbox_received(DictionaryIterator *iterator, void *context);
+int termo_glance_text(char *buffer, size_t size);
 
 #endif /* TERMO_H */
@@ -1,62 +1,322 @@
-var xhrRequest = function (url, type, callback) {
+var messageQueue = require('./msgqueue');
+var weather = require('./weather');
+
+var DEFAULT_CITY = "tomsk";
+
+// Location lookups are shared between many weather fetches: a cached
+// fix is fine for hours and the city is only resolved again after
+// moving further than LOCATION_MOVE_KM.
+var LOCATION_MAX_AGE = 3 * 60 * 60 * 1000;
+var LOCATION_TIMEOUT = 15 * 1000;
+var LOCATION_MOVE_KM = 20;
+var LOCATION_CACHE_KEY = "termo-location";
+// Coordinates of a typed city and the last ones the watch got for its
+// sunrise/sunset, so they are looked up and sent only when changed.
+var CITY_COORDS_CACHE_KEY = "termo-city-coords";
+var SENT_COORDS_KEY = "termo-sent-coords";
+// In push mode the phone refreshes every PUSH_REFRESH and sends the
+// weather only when it changed or PUSH_HEARTBEAT passed since the last
+// send, well within the MAX_AGE after which the watch drops it. Once
+// nothing came for 40 minutes the watch asks, and that always gets an
+// answer.
+var PUSH_REFRESH = 10 * 60 * 1000;
+var PUSH_HEARTBEAT = 30 * 60 * 1000;
+var PUSHED_KEY = "termo-pushed";
+// Lookups that don't answer by then count as failed
+var REQUEST_TIMEOUT = 15 * 1000;
+
+var xhrRequest = function (url, type, callback, errorCallback) {
     var xhr = new XMLHttpRequest();
     xhr.onload = function () {
         callback(this.responseText);
     };
+    if (errorCallback) {
+        xhr.onerror = xhr.ontimeout = errorCallback;
+    }
     xhr.open(type, url);
+    xhr.timeout = REQUEST_TIMEOUT;
     xhr.send();
 };
 
-function getWeather() {
-    // Construct URL
-    var url = "http://termopogoda.ru/data.json?city=tomsk";
+function readJSON(key) {
+    try {
+        return JSON.parse(localStorage.getItem(key));
+    } catch (e) {
+        return null;
+    }
+}
 
-    // Send request to OpenWeatherMap
-    xhrRequest(url, 'GET', function(responseText) {
-        // responseText contains a JSON object with weather info
-        var json = JSON.parse(responseText);
+function distanceKm(lat1, lon1, lat2, lon2) {
+    var rad = Math.PI / 180;
+    var dLat = (lat2 - lat1) * rad;
+    var dLon = (lon2 - lon1) * rad;
+    var a = Math.sin(dLat / 2) * Math.sin(dLat / 2) +
+        Math.cos(lat1 * rad) * Math.cos(lat2 * rad) * Math.sin(dLon / 2) * Math.sin(dLon / 2);
+    return 6371 * 2 * Math.atan2(Math.sqrt(a), Math.sqrt(1 - a));
+}
 
-        // Temperature in Kelvin requires adjustment
-        var temperature = String(json.current_temp);
+function resolveCity(coords, callback) {
+    var url = "https://nominatim.openstreetmap.org/reverse?format=json&zoom=10&accept-language=en" +
+        "&lat=" + coords.latitude + "&lon=" + coords.longitude;
 
-        if (parseFloat(temperature) > 0) {
-            temperature = "+" + temperature;
+    xhrRequest(url, 'GET', function(responseText) {
+        var address;
+        try {
+            address = JSON.parse(responseText).address || {};
+        } catch (e) {
+            address = {};
         }
+        var city = address.city || address.town || address.village;
+        callback(city ? city.toLowerCase() : null);
+    }, function() {
+        callback(null);
+    });
+}
 
-        temperature+= "C";
-        
-        console.log("Temperature is " + temperature);
+function geocodeCity(city, callback) {
+    var cached = readJSON(CITY_COORDS_CACHE_KEY);
+    if (cached && cached.city === city) {
+        callback(cached);
+        return;
+    }
 
-        // Assemble dictionary using our keys
-        var dictionary = {
-            "TEMPERATURE": temperature
+    var url = "https://nominatim.openstreetmap.org/search?format=json&limit=1&q=" + encodeURIComponent(city);
+
+    xhrRequest(url, 'GET', function(responseText) {
+        var place;
+        try {
+            place = JSON.parse(responseText)[0];
+        } catch (e) {
+            place = null;
+        }
+        if (!place) {
+            callback(null);
+            return;
+        }
+        var coords = {
+            latitude: parseFloat(place.lat),
+            longitude: parseFloat(place.lon),
+            city: city
         };
+        localStorage.setItem(CITY_COORDS_CACHE_KEY, JSON.stringify(coords));
+        callback(coords);
+    }, function() {
+        callback(null);
+    });
+}
 
-        // Send to Pebble
-        Pebble.sendAppMessage(
-            dictionary,
-            function() {
-                console.log("Weather info sent to Pebble successfully!");
-            },
-            function(e) {
-                console.log("Error sending weather info to Pebble: " + JSON.stringify(e));
+// Location for the sunrise/sunset, in hundredths of a degree, or an
+// empty dictionary when the watch already has it.
+function coordsMessage(coords) {
+    if (!coords) {
+        return {};
+    }
+    var message = {
+        "LATITUDE": Math.round(coords.latitude * 100),
+        "LONGITUDE": Math.round(coords.longitude * 100)
+    };
+    var sent = readJSON(SENT_COORDS_KEY);
+    if (sent && sent.LATITUDE === message.LATITUDE && sent.LONGITUDE === message.LONGITUDE) {
+        return {};
+    }
+    return message;
+}
+
+// Condition codes of the watch icons (see fonttools/weather_icons.py)
+var CONDITION_CLEAR = 1;
+var CONDITION_PARTLY_CLOUDY = 2;
+var CONDITION_CLOUDY = 3;
+var CONDITION_RAIN = 4;
+var CONDITION_SNOW = 5;
+var CONDITION_STORM = 6;
+var CONDITION_FOG = 7;
+
+// WMO weather interpretation code to icon
+function conditionFromCode(code) {
+    if (code <= 1) return CONDITION_CLEAR;
+    if (code == 2) return CONDITION_PARTLY_CLOUDY;
+    if (code == 3) return CONDITION_CLOUDY;
+    if (code == 45 || code == 48) return CONDITION_FOG;
+    if ((code >= 71 && code <= 77) || code == 85 || code == 86) return CONDITION_SNOW;
+    if (code >= 95) return CONDITION_STORM;
+    return CONDITION_RAIN;
+}
+
+function getCondition(coords, callback) {
+    if (!coords) {
+        callback(null);
+        return;
+    }
+
+    var url = "https://api.open-meteo.com/v1/forecast?current=weather_code" +
+        "&latitude=" + coords.latitude + "&longitude=" + coords.longitude;
+
+    xhrRequest(url, 'GET', function(responseText) {
+        try {
+            callback(conditionFromCode(JSON.parse(responseText).current.weather_code));
+        } catch (e) {
+            callback(null);
+        }
+    }, function() {
+        callback(null);
+    });
+}
+
+function getCity(callback) {
+    var settings = readJSON("clay-settings") || {};
+    var city = settings.CITY || DEFAULT_CITY;
+    if (!settings.CITY_AUTO) {
+        geocodeCity(city, function(coords) {
+            callback(city, coords);
+        });
+        return;
+    }
+
+    var cached = readJSON(LOCATION_CACHE_KEY);
+    navigator.geolocation.getCurrentPosition(
+        function(pos) {
+            var coords = pos.coords;
+            if (cached && distanceKm(cached.latitude, cached.longitude, coords.latitude, coords.longitude) < LOCATION_MOVE_KM) {
+                callback(cached.city, cached);
+                return;
             }
-        );
+
+            resolveCity(coords, function(resolved) {
+                if (!resolved) {
+                    callback(cached ? cached.city : city, coords);
+                    return;
+                }
+                console.log("Location resolved to " + resolved);
+                localStorage.setItem(LOCATION_CACHE_KEY, JSON.stringify({
+                    latitude: coords.latitude,
+                    longitude: coords.longitude,
+                    city: resolved
+                }));
+                callback(resolved, coords);
+            });
+        },
+        function(err) {
+            console.log("Location error: " + err.message);
+            callback(cached ? cached.city : city, cached);
+        },
+        {maximumAge: LOCATION_MAX_AGE, timeout: LOCATION_TIMEOUT, enableHighAccuracy: false}
+    );
+}
+
+function pushMode() {
+    return !!(readJSON("clay-settings") || {}).PUSH_MODE;
+}
+
+// Pushed weather only goes out when the watch would show something new
+// or is due for a heartbeat.
+function isNews(dictionary) {
+    var pushed = readJSON(PUSHED_KEY);
+    return !pushed ||
+        pushed.TEMPERATURE !== dictionary.TEMPERATURE ||
+        pushed.CONDITION !== dictionary.CONDITION ||
+        Date.now() - pushed.time >= PUSH_HEARTBEAT ||
+        "LATITUDE" in dictionary;
+}
+
+function sendWeather(dictionary) {
+    if (pushMode() && !isNews(dictionary)) {
+        console.log("Weather unchanged, not pushed");
+        return;
+    }
+
+    // Send to Pebble, together with anything else queued meanwhile
+    messageQueue.send(dictionary, function(sent) {
+        console.log("Weather info sent to Pebble successfully!");
+        localStorage.setItem(PUSHED_KEY, JSON.stringify({
+            TEMPERATURE: sent.TEMPERATURE,
+            CONDITION: sent.CONDITION,
+            time: Date.now()
+        }));
+        if ("LATITUDE" in sent) {
+            localStorage.setItem(SENT_COORDS_KEY, JSON.stringify({
+                LATITUDE: sent.LATITUDE,
+                LONGITUDE: sent.LONGITUDE
+            }));
+        }
+    });
+}
+
+function getWeather() {
+    getCity(function(city, coords) {
+        weather.fetchWeather({city: city, coords: coords}, function(reading) {
+            if (!reading) {
+                console.log("No weather for " + city);
+                return;
+            }
+
+            var temperature = String(Math.round(reading.temperature * 10) / 10);
+
+            if (reading.temperature > 0) {
+                temperature = "+" + temperature;
+            }
+
+            temperature+= "C";
+
+            console.log("Temperature in " + city + " is " + temperature + " (" + reading.provider + ")");
+
+            function send(condition) {
+                // Assemble dictionary using our keys
+                var dictionary = coordsMessage(coords);
+                dictionary["TEMPERATURE"] = temperature;
+                if (condition) {
+                    dictionary["CONDITION"] = condition;
+                }
+
+                sendWeather(dictionary);
+            }
+
+            if (reading.weatherCode !== undefined) {
+                send(conditionFromCode(reading.weatherCode));
+            } else {
+                getCondition(coords, send);
+            }
+        });
     });
 }
 
+var pushTimer = null;
+
+function schedulePush() {
+    clearInterval(pushTimer);
+    pushTimer = pushMode() ? setInterval(getWeather, PUSH_REFRESH) : null;
+}
+
 module.exports = function() {
     // Listen for when the watchface is opened
     Pebble.addEventListener('ready', function(e) {
         console.log("PebbleKit JS ready!");
 
+        // The watch may have lost its location and weather, send them
+        // once per launch
+        localStorage.removeItem(SENT_COORDS_KEY);
+        localStorage.removeItem(PUSHED_KEY);
+
         // Get the initial weather
         getWeather();
+        schedulePush();
     });
 
     // Listen for when an AppMessage is received
     Pebble.addEventListener('appmessage', function(e) {
         console.log("AppMessage received!");
+        localStorage.removeItem(PUSHED_KEY);
         getWeather();
     });
+
+    // City or mode may have changed: refetch once Clay has stored the
+    // settings
+    Pebble.addEventListener('webviewclosed', function(e) {
+        if (e && e.response) {
+            setTimeout(function() {
+                localStorage.removeItem(PUSHED_KEY);
+                getWeather();
+                schedulePush();
+            }, 0);
+        }
+    });
 }
@@ -0,0 +1,80 @@
+#include "pebble.h"
+#include "theme.h"
+
+#ifdef PBL_COLOR
+typedef struct {
+    GColor background;
+    GColor foreground;
+    GColor accent;
+} Theme;
+
+// Indexed by the THEME value from the config page.
+static const Theme themes[] = {
+    { .background = {GColorBlackARGB8},       .foreground = {GColorWhiteARGB8},       .accent = {GColorGreenARGB8} },
+    { .background = {GColorOxfordBlueARGB8},  .foreground = {GColorCyanARGB8},        .accent = {GColorMintGreenARGB8} },
+    { .background = {GColorDarkGreenARGB8},   .foreground = {GColorMintGreenARGB8},   .accent = {GColorYellowARGB8} },
+    { .background = {GColorBlackARGB8},       .foreground = {GColorChromeYellowARGB8}, .accent = {GColorChromeYellowARGB8} },
+};
+
+static const Theme *current_theme = &themes[0];
+
+static int color_weight(GColor color) {
+    return color.r + color.g + color.b;
+}
+
+// Swaps the two colors of a 1-bit palettized bitmap in place: the ink
+// takes the given color, the other entry becomes transparent. Fresh
+// resources have an opaque black ink on white (or an opaque ink on
+// transparent), themed ones always have a transparent paper, so the
+// ink entry is found either way and the bitmap can be themed again.
+void theme_recolor(GBitmap *bitmap, GColor ink) {
+    if (!bitmap || gbitmap_get_format(bitmap) != GBitmapFormat1BitPalette) {
+        return;
+    }
+
+    GColor *palette = gbitmap_get_palette(bitmap);
+    int ink_index;
+    if (palette[0].a == 0 || palette[1].a == 0) {
+        ink_index = palette[0].a == 0 ? 1 : 0;
+    } else {
+        ink_index = color_weight(palette[0]) <= color_weight(palette[1]) ? 0 : 1;
+    }
+
+    palette[ink_index] = ink;
+    palette[1 - ink_index] = GColorClear;
+}
+#endif
+
+// public methods
+void theme_set(int theme) {
+    #ifdef PBL_COLOR
+    if (theme < 0 || theme >= (int)ARRAY_LENGTH(themes)) {
+        theme = 0;
+    }
+    current_theme = &themes[theme];
+    #endif
+}
+
+GColor theme_foreground(bool inverse) {
+    #ifdef PBL_COLOR
+    return inverse ? current_theme->background : current_theme->foreground;
+    #else
+    return inverse ? GColorBlack : GColorWhite;
+    #endif
+}
+
+GColor theme_background(bool inverse) {
+    #ifdef PBL_COLOR
+    return inverse ? current_theme->foreground : current_theme->background;
+    #else
+    return inverse ? GColorWhite : GColorBlack;
+    #endif
+}
+
+GColor theme_accent(void) {
+    #ifdef PBL_COLOR
+    return current_theme->accent;
+    #else
+    return GColorWhite;
+    #endif
+}
@@ -0,0 +1,14 @@
+#ifndef THEME_H
+#define THEME_H
+
+// Color themes. On black and white platforms there is a single theme
+// and the faces keep inverting through compositing modes.
+void theme_set(int theme);
+GColor theme_foreground(bool inverse);
+GColor theme_background(bool inverse);
+GColor theme_accent(void);
+#ifdef PBL_COLOR
+void theme_recolor(GBitmap *bitmap, GColor ink);
+#endif
+
+#endif /* THEME_H */
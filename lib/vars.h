@@ -4,6 +4,11 @@
 #define STYLE_KEY 1
 #define TERMO_KEY 2
 #define TERMO_TS_KEY 3
-#define STATUS_ROUND_PADDING_H 34
+#define THEME_KEY 4
+#define LOCATION_KEY 6
+#define AUTO_INVERSE_KEY 7
+#define TERMO_CONDITION_KEY 8
+#define TERMO_PUSH_KEY 9
+#define STEPS_SNAPSHOT_KEY 10
 
 #endif /* VARS_H */
@@ -0,0 +1,209 @@
+// Weather providers raced against each other. Every provider that can
+// serve the place is asked, the best ranked one first and the others
+// STAGGER_DELAY apart (or right away when one fails), the first valid
+// reading wins and the requests still running are aborted. Nothing
+// outlives RACE_DEADLINE.
+//
+// Latency and failures of every provider are kept in localStorage and
+// rank the providers, so a slow or failing one only gets asked once
+// the others had their head start. A request aborted because another
+// provider won only counts as a failure when it had already run longer
+// than the winner took; otherwise nothing is known about it.
+//
+// Base URLs can be pointed at local stand-in servers by storing
+// {"termopogoda": "http://127.0.0.1:8000", ...} under PROVIDER_URLS_KEY.
+var RACE_DEADLINE = 10 * 1000;
+var STAGGER_DELAY = 1500;
+var STATS_KEY = "termo-provider-stats";
+var PROVIDER_URLS_KEY = "termo-provider-urls";
+// weight of the newest sample in the latency and failure averages
+var STATS_WEIGHT = 0.3;
+
+function readJSON(key) {
+    try {
+        return JSON.parse(localStorage.getItem(key));
+    } catch (e) {
+        return null;
+    }
+}
+
+function parseNumber(value) {
+    var number = parseFloat(value);
+    return isFinite(number) ? number : null;
+}
+
+var PROVIDERS = [
+    {
+        name: "termopogoda",
+        baseUrl: "http://termopogoda.ru",
+        canServe: function(place) {
+            return !!place.city;
+        },
+        url: function(baseUrl, place) {
+            return baseUrl + "/data.json?city=" + encodeURIComponent(place.city);
+        },
+        parse: function(json) {
+            return {temperature: parseNumber(json.current_temp)};
+        }
+    },
+    {
+        name: "open-meteo",
+        baseUrl: "https://api.open-meteo.com",
+        canServe: function(place) {
+            return !!place.coords;
+        },
+        url: function(baseUrl, place) {
+            return baseUrl + "/v1/forecast?current=temperature_2m,weather_code" +
+                "&latitude=" + place.coords.latitude + "&longitude=" + place.coords.longitude;
+        },
+        parse: function(json) {
+            return {temperature: parseNumber(json.current.temperature_2m), weatherCode: json.current.weather_code};
+        }
+    }
+];
+
+function recordResult(name, ok, latency) {
+    var stats = readJSON(STATS_KEY) || {};
+    var entry = stats[name] || {latency: latency, failures: ok ? 0 : 1, ok: 0, failed: 0};
+
+    entry.latency = Math.round(entry.latency + STATS_WEIGHT * (latency - entry.latency));
+    entry.failures = entry.failures + STATS_WEIGHT * ((ok ? 0 : 1) - entry.failures);
+    entry[ok ? "ok" : "failed"]++;
+
+    stats[name] = entry;
+    localStorage.setItem(STATS_KEY, JSON.stringify(stats));
+}
+
+// Expected time to a valid reading: a failure costs the whole deadline.
+function score(stats, name) {
+    var entry = stats[name];
+    if (!entry) {
+        return 0;
+    }
+    return entry.latency + entry.failures * RACE_DEADLINE;
+}
+
+function rankedProviders(place) {
+    var stats = readJSON(STATS_KEY) || {};
+    return PROVIDERS.filter(function(provider) {
+        return provider.canServe(place);
+    }).sort(function(a, b) {
+        return score(stats, a.name) - score(stats, b.name);
+    });
+}
+
+// Calls `callback` once, with the first valid reading or null. A
+// reading has the temperature in degrees, the WMO `weatherCode` when the
+// provider knows it and the name of the `provider`.
+function fetchWeather(place, callback) {
+    var providers = rankedProviders(place);
+    var urls = readJSON(PROVIDER_URLS_KEY) || {};
+    var running = [];
+    var next = 0;
+    var failed = 0;
+    var done = false;
+    var staggerTimer = null;
+    var deadlineTimer = null;
+
+    // `latency` is the time the winning request took.
+    function finish(reading, latency) {
+        done = true;
+        clearTimeout(staggerTimer);
+        clearTimeout(deadlineTimer);
+        running.forEach(function(request) {
+            request.xhr.abort();
+            var elapsed = Date.now() - request.started;
+            if (reading && elapsed > latency) {
+                recordResult(request.provider.name, false, elapsed);
+            }
+        });
+        running = [];
+        callback(reading);
+    }
+
+    function settle(request, ok) {
+        running.splice(running.indexOf(request), 1);
+        recordResult(request.provider.name, ok, Date.now() - request.started);
+    }
+
+    function fail(request) {
+        console.log("Weather from " + request.provider.name + " failed");
+        settle(request, false);
+        if (++failed == providers.length) {
+            finish(null);
+        } else {
+            startNext();
+        }
+    }
+
+    function start(provider) {
+        var request = {provider: provider, started: Date.now(), xhr: new XMLHttpRequest()};
+        request.xhr.onload = function() {
+            if (done) {
+                return;
+            }
+            var reading;
+            try {
+                reading = this.status == 200 ? provider.parse(JSON.parse(this.responseText)) : null;
+            } catch (e) {
+                reading = null;
+            }
+            if (!reading || reading.temperature === null) {
+                fail(request);
+                return;
+            }
+            settle(request, true);
+            reading.provider = provider.name;
+            finish(reading, Date.now() - request.started);
+        };
+        request.xhr.onerror = request.xhr.ontimeout = function() {
+            if (!done) {
+                fail(request);
+            }
+        };
+        // in the list first, a failing open() or send() settles it at once
+        running.push(request);
+        try {
+            request.xhr.open('GET', provider.url(urls[provider.name] || provider.baseUrl, place));
+            request.xhr.timeout = RACE_DEADLINE;
+            request.xhr.send();
+        } catch (e) {
+            // unless an error handler already failed it
+            if (running.indexOf(request) >= 0) {
+                fail(request);
+            }
+        }
+    }
+
+    function startNext() {
+        clearTimeout(staggerTimer);
+        if (done || next >= providers.length) {
+            return;
+        }
+        // armed before starting, so a provider that fails right away
+        // moves on to the next one instead of leaving a second timer
+        var provider = providers[next++];
+        if (next < providers.length) {
+            staggerTimer = setTimeout(startNext, STAGGER_DELAY);
+        }
+        start(provider);
+    }
+
+    if (!providers.length) {
+        callback(null);
+        return;
+    }
+
+    deadlineTimer = setTimeout(function() {
+        console.log("Weather providers missed the deadline");
+        running.forEach(function(request) {
+            recordResult(request.provider.name, false, Date.now() - request.started);
+        });
+        finish(null);
+    }, RACE_DEADLINE);
+    startNext();
+}
+
+module.exports = {
+    fetchWeather: fetchWeather
+};
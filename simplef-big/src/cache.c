@@ -0,0 +1 @@
+../../lib/cache.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../lib/cache.h
\ No newline at end of file
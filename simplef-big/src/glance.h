@@ -0,0 +1 @@
+../../lib/glance.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../lib/health.c
\ No newline at end of file
@@ -1,46 +1,66 @@
 #include "pebble.h"
 #include "vars.h"
+#include "render_stats.h"
+#include "soak_stats.h"
+#include "theme.h"
+#include "schedule.h"
 #include "simplebig.h"
 #include "status.h"
+#include "rings.h"
+#include "glance.h"
+#include "health.h"
 
 Window *window;
 
 static void update_time(struct tm *tick_time) {
     simplebig_update_time(tick_time);
+    rings_update_time(tick_time);
+    health_update_time(tick_time);
 }
 
 static void set_style(void) {
     bool inverse = persist_read_bool(STYLE_KEY);
-    
-    GColor background_color  = inverse ? GColorWhite : GColorBlack;
+    theme_set(persist_read_int(THEME_KEY));
+
+    GColor background_color  = theme_background(inverse);
     
     window_set_background_color(window, background_color);
 
+    rings_set_style(inverse);
     simplebig_set_style(inverse);
     status_set_style(inverse);
+    glance_set_style(inverse);
+    health_set_style(inverse);
 }
 
 static void update_bounds(void) {
     simplebig_update_bounds();
 }
 
-static void force_update(void) {
-    status_update();
-
-    time_t now = time(NULL);
-    update_time(localtime(&now));
-
-    update_bounds();
+static void flush_updates(uint32_t reasons) {
+    if (reasons & UPDATE_STYLE) {
+        set_style();
+    }
+    if (reasons & UPDATE_STATUS) {
+        status_update();
+    }
+    if (reasons & UPDATE_TIME) {
+        time_t now = time(NULL);
+        update_time(localtime(&now));
+    }
+    if (reasons & UPDATE_BOUNDS) {
+        update_bounds();
+    }
 }
 
 static void handle_minute_tick(struct tm *tick_time, TimeUnits units_changed) {
+    soak_stats_tick(tick_time);
     update_time(tick_time);
 }
 
 static void handle_tap(AccelAxisType axis, int32_t direction) {
     persist_write_bool(STYLE_KEY, !persist_read_bool(STYLE_KEY));
-    set_style();
-    force_update();
+    schedule_update(UPDATE_STYLE);
     vibes_long_pulse();
     accel_tap_service_unsubscribe();
 }
@@ -55,15 +75,24 @@ static void handle_unobstructed_change(AnimationProgress progress, void *context
 
 // MESSAGING
 static void inbox_received_callback(DictionaryIterator *iterator, void *context) {
+    soak_stats_wakeup();
+    soak_stats_message(iterator, false);
 
     // Look for item
     Tuple *t = dict_find(iterator, MESSAGE_KEY_INVERSE);
- 
+    Tuple *theme_t = dict_find(iterator, MESSAGE_KEY_THEME);
+
+    // Theme comes with INVERSE from the config page
+    if (theme_t) {
+        int theme = theme_t->type == TUPLE_CSTRING ? atoi(theme_t->value->cstring) : theme_t->value->int32;
+        persist_write_int(THEME_KEY, theme);
+        schedule_update(UPDATE_STYLE);
+    }
+
     // For all items
     if (t) {
         persist_write_bool(STYLE_KEY, t->value->int32 == 1);
-        set_style();
-        force_update();
+        schedule_update(UPDATE_STYLE);
         vibes_long_pulse();
     }
 }
@@ -83,11 +112,16 @@ static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
 
 static void handle_init(void) {
     window = window_create();
-    window_stack_push(window, true /* Animated */);
+    window_stack_push(window, false /* Animated */);
+    render_stats_init(window);
 
-    // child init
+    // child init, rings first: they are drawn below everything
+    rings_init(window, simplebig_invalidate_cache);
     simplebig_init(window);
     status_init(window);
+    health_init(window);
+    glance_init(window, status_glance_text);
+    render_stats_attach(window);
 
     // Register callbacks
     app_message_register_inbox_received(inbox_received_callback);
@@ -95,8 +129,10 @@ static void handle_init(void) {
     app_message_register_outbox_failed(outbox_failed_callback);
     app_message_register_outbox_sent(outbox_sent_callback);
 
-    // Open AppMessage
-    AppMessageResult result = app_message_open(APP_MESSAGE_INBOX_SIZE_MINIMUM, APP_MESSAGE_OUTBOX_SIZE_MINIMUM);
+    // Open AppMessage, the inbox sized for the settings: INVERSE as an
+    // int and THEME as a one digit string
+    uint32_t inbox_size = dict_calc_buffer_size(2, sizeof(int32_t), sizeof("0"));
+    AppMessageResult result = app_message_open(inbox_size, APP_MESSAGE_OUTBOX_SIZE_MINIMUM);
     if (result != APP_MSG_OK) {
         APP_LOG(APP_LOG_LEVEL_ERROR, "Can't open inbox");
     }
@@ -108,16 +144,22 @@ static void handle_init(void) {
     };
     unobstructed_area_service_subscribe(ua_handler, NULL);
 
-    // style
-    set_style();
-
-    // draw first frame
-    force_update();
+    // style and first frame right away, status_init() peeked the rest
+    schedule_init(flush_updates);
+    schedule_update(UPDATE_STYLE | UPDATE_TIME | UPDATE_BOUNDS);
+    schedule_flush();
 }
 
 static void handle_deinit(void) {
+    soak_stats_report();
+    schedule_deinit();
+    // drops the probes of the layers destroyed below
+    render_stats_deinit();
+    glance_deinit();
+    health_deinit();
     status_deinit();
     simplebig_deinit();
+    rings_deinit();
     
     tick_timer_service_unsubscribe();
     
@@ -0,0 +1 @@
+../../lib/render_stats.c
\ No newline at end of file
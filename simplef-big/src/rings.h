@@ -0,0 +1 @@
+../../lib/rings.h
\ No newline at end of file
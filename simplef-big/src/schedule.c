@@ -0,0 +1 @@
+../../lib/schedule.c
\ No newline at end of file
@@ -2,6 +2,10 @@
 #define VARS_H
 
 #define STYLE_KEY 1
-#define STATUS_ROUND_PADDING_H 55
+#define THEME_KEY 4
+#define STEPS_SNAPSHOT_KEY 10
+
+// roll the changed digits on minute change, see simplebig.c
+#define DIGIT_ANIMATION
 
 #endif /* VARS_H */
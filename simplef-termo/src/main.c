@@ -1,49 +1,96 @@
 #include "pebble.h"
 #include "vars.h"
+#include "render_stats.h"
+#include "soak_stats.h"
+#include "theme.h"
+#include "schedule.h"
 #include "simplebig.h"
 #include "status.h"
+#include "rings.h"
+#include "glance.h"
 #include "termo.h"
+#include "solar.h"
 
 Window *window;
 
+// last day/night state used by auto inverse
+static bool is_day = false;
+
+static bool auto_inverse_changed(struct tm *tick_time) {
+    bool new_is_day;
+    if (!persist_read_bool(AUTO_INVERSE_KEY) || !solar_is_day(tick_time, &new_is_day)) {
+        return false;
+    }
+    bool changed = new_is_day != is_day;
+    is_day = new_is_day;
+    return changed;
+}
+
 static void update_time(struct tm *tick_time) {
     simplebig_update_time(tick_time);
+    rings_update_time(tick_time);
     termo_update_time(tick_time);
+    solar_update_time(tick_time);
+
+    if (auto_inverse_changed(tick_time)) {
+        schedule_update(UPDATE_STYLE);
+    }
+}
+
+static int glance_text(char *buffer, size_t size) {
+    int length = status_glance_text(buffer, size);
+    return length + termo_glance_text(buffer + length, size - length);
 }
 
 static void set_style(void) {
     bool inverse = persist_read_bool(STYLE_KEY);
-    
-    GColor background_color  = inverse ? GColorWhite : GColorBlack;
+    time_t now = time(NULL);
+    if (persist_read_bool(AUTO_INVERSE_KEY) && solar_is_day(localtime(&now), &is_day)) {
+        // light face by day, dark face by night
+        inverse = is_day;
+    }
+    theme_set(persist_read_int(THEME_KEY));
+
+    GColor background_color  = theme_background(inverse);
     
     window_set_background_color(window, background_color);
 
+    rings_set_style(inverse);
     simplebig_set_style(inverse);
     status_set_style(inverse);
+    glance_set_style(inverse);
     termo_set_style(inverse);
+    solar_set_style(inverse);
 }
 
 static void update_bounds(void) {
     simplebig_update_bounds();
 }
 
-static void force_update(void) {
-    status_update();
-
-    time_t now = time(NULL);
-    update_time(localtime(&now));
-
-    update_bounds();
+static void flush_updates(uint32_t reasons) {
+    if (reasons & UPDATE_STYLE) {
+        set_style();
+    }
+    if (reasons & UPDATE_STATUS) {
+        status_update();
+    }
+    if (reasons & UPDATE_TIME) {
+        time_t now = time(NULL);
+        update_time(localtime(&now));
+    }
+    if (reasons & UPDATE_BOUNDS) {
+        update_bounds();
+    }
 }
 
 static void handle_minute_tick(struct tm *tick_time, TimeUnits units_changed) {
+    soak_stats_tick(tick_time);
     update_time(tick_time);
 }
 
 static void handle_tap(AccelAxisType axis, int32_t direction) {
     persist_write_bool(STYLE_KEY, !persist_read_bool(STYLE_KEY));
-    set_style();
-    force_update();
+    schedule_update(UPDATE_STYLE);
     vibes_long_pulse();
     accel_tap_service_unsubscribe();
 }
@@ -58,19 +105,41 @@ static void handle_unobstructed_change(AnimationProgress progress, void *context
 
 // MESSAGING
 static void inbox_received_callback(DictionaryIterator *iterator, void *context) {
+    soak_stats_wakeup();
+    soak_stats_message(iterator, false);
 
     // Look for item
     Tuple *t = dict_find(iterator, MESSAGE_KEY_INVERSE);
- 
+    Tuple *theme_t = dict_find(iterator, MESSAGE_KEY_THEME);
+    Tuple *auto_inverse_t = dict_find(iterator, MESSAGE_KEY_AUTO_INVERSE);
+
+    // Theme comes with INVERSE from the config page
+    if (theme_t) {
+        int theme = theme_t->type == TUPLE_CSTRING ? atoi(theme_t->value->cstring) : theme_t->value->int32;
+        persist_write_int(THEME_KEY, theme);
+        schedule_update(UPDATE_STYLE);
+    }
+
+    if (auto_inverse_t) {
+        persist_write_bool(AUTO_INVERSE_KEY, auto_inverse_t->value->int32 == 1);
+        schedule_update(UPDATE_STYLE);
+    }
+
     // For all items
     if (t) {
         persist_write_bool(STYLE_KEY, t->value->int32 == 1);
-        set_style();
-        force_update();
+        schedule_update(UPDATE_STYLE);
         vibes_long_pulse();
     }
 
     termo_inbox_received(iterator, context);
+    solar_inbox_received(iterator, context);
+
+    // a new location may flip day and night right away
+    time_t now = time(NULL);
+    if (auto_inverse_changed(localtime(&now))) {
+        schedule_update(UPDATE_STYLE);
+    }
 }
 
 static void inbox_dropped_callback(AppMessageResult reason, void *context) {
@@ -88,12 +157,17 @@ static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
 
 static void handle_init(void) {
     window = window_create();
-    window_stack_push(window, true /* Animated */);
+    window_stack_push(window, false /* Animated */);
+    render_stats_init(window);
 
-    // child init
+    // child init, rings first: they are drawn below everything
+    rings_init(window, simplebig_invalidate_cache);
     simplebig_init(window);
     status_init(window);
     termo_init(window);
+    solar_init(window);
+    glance_init(window, glance_text);
+    render_stats_attach(window);
 
     // Register callbacks
     app_message_register_inbox_received(inbox_received_callback);
@@ -101,8 +175,14 @@ static void handle_init(void) {
     app_message_register_outbox_failed(outbox_failed_callback);
     app_message_register_outbox_sent(outbox_sent_callback);
 
-    // Open AppMessage
-    AppMessageResult result = app_message_open(APP_MESSAGE_INBOX_SIZE_MINIMUM, APP_MESSAGE_OUTBOX_SIZE_MINIMUM);
+    // Open AppMessage, the inbox sized for the largest dictionary the
+    // phone sends, settings and weather merged by msgqueue.js: INVERSE,
+    // AUTO_INVERSE, PUSH_MODE, CONDITION, LATITUDE and LONGITUDE as ints,
+    // THEME as a one digit string and the TEMPERATURE text
+    uint32_t inbox_size = dict_calc_buffer_size(8,
+        sizeof(int32_t), sizeof(int32_t), sizeof(int32_t), sizeof(int32_t), sizeof(int32_t), sizeof(int32_t),
+        sizeof("0"), TERMO_TEXT_SIZE);
+    AppMessageResult result = app_message_open(inbox_size, APP_MESSAGE_OUTBOX_SIZE_MINIMUM);
     if (result != APP_MSG_OK) {
         APP_LOG(APP_LOG_LEVEL_ERROR, "Can't open inbox");
     }
@@ -114,17 +194,23 @@ static void handle_init(void) {
     };
     unobstructed_area_service_subscribe(ua_handler, NULL);
 
-    // style
-    set_style();
-
-    // draw first frame
-    force_update();
+    // style and first frame right away, status_init() peeked the rest
+    schedule_init(flush_updates);
+    schedule_update(UPDATE_STYLE | UPDATE_TIME | UPDATE_BOUNDS);
+    schedule_flush();
 }
 
 static void handle_deinit(void) {
+    soak_stats_report();
+    schedule_deinit();
+    // drops the probes of the layers destroyed below
+    render_stats_deinit();
+    glance_deinit();
+    solar_deinit();
     termo_deinit();
     status_deinit();
     simplebig_deinit();
+    rings_deinit();
     
     tick_timer_service_unsubscribe();
     
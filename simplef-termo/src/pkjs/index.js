@@ -1,5 +1,34 @@
 require('./termo')();
 const clayConfig = require('./clay');
+const termoClayConfig = require('./termo-clay');
 const Clay = require('pebble-clay');
+const messageQueue = require('./msgqueue');
+const messageKeys = require('message_keys');
 
-new Clay(clayConfig);
+// The city settings stay on the phone: termo.js reads them from the
+// stored Clay settings, and a free-form city name would not fit the
+// watch inbox.
+const PHONE_ONLY_KEYS = ['CITY', 'CITY_AUTO'];
+
+// weather section goes right before the submit button
+clayConfig.splice(clayConfig.length - 1, 0, termoClayConfig);
+
+// Settings go through the message queue too, so a save never races a
+// weather update.
+const clay = new Clay(clayConfig, null, { autoHandleEvents: false });
+
+Pebble.addEventListener('showConfiguration', function(e) {
+    Pebble.openURL(clay.generateUrl());
+});
+
+Pebble.addEventListener('webviewclosed', function(e) {
+    if (e && e.response) {
+        const settings = clay.getSettings(e.response);
+        // keyed by name or by message key id
+        PHONE_ONLY_KEYS.forEach(function(key) {
+            delete settings[key];
+            delete settings[messageKeys[key]];
+        });
+        messageQueue.send(settings);
+    }
+});
@@ -0,0 +1 @@
+../../../lib/msgqueue.js
\ No newline at end of file
@@ -0,0 +1 @@
+../../../lib/termo-clay.js
\ No newline at end of file
@@ -0,0 +1 @@
+../../../lib/weather.js
\ No newline at end of file
@@ -0,0 +1 @@
+../../lib/rings.c
\ No newline at end of file
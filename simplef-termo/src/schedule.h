@@ -0,0 +1 @@
+../../lib/schedule.h
\ No newline at end of file
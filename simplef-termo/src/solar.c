@@ -0,0 +1 @@
+../../lib/solar.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../lib/solar.h
\ No newline at end of file
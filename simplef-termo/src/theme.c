@@ -0,0 +1 @@
+../../lib/theme.c
\ No newline at end of file
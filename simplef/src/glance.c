@@ -0,0 +1 @@
+../../lib/glance.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../lib/health.h
\ No newline at end of file
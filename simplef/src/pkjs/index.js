@@ -1,4 +1,17 @@
 const clayConfig = require('./clay');
 const Clay = require('pebble-clay');
+const messageQueue = require('./msgqueue');
 
-new Clay(clayConfig);
+// Settings go through the message queue too, so a save never races a
+// weather update.
+const clay = new Clay(clayConfig, null, { autoHandleEvents: false });
+
+Pebble.addEventListener('showConfiguration', function(e) {
+    Pebble.openURL(clay.generateUrl());
+});
+
+Pebble.addEventListener('webviewclosed', function(e) {
+    if (e && e.response) {
+        messageQueue.send(clay.getSettings(e.response));
+    }
+});
@@ -0,0 +1 @@
+../../lib/render_stats.h
\ No newline at end of file
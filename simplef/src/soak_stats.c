@@ -0,0 +1 @@
+../../lib/soak_stats.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../lib/soak_stats.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../lib/theme.h
\ No newline at end of file